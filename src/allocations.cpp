@@ -0,0 +1,98 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "allocations.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#ifdef CHIP8_COUNT_ALLOCATIONS
+
+namespace
+{
+    std::atomic<uint64_t> allocationCount {0};
+
+    void* countedAllocate(std::size_t size, std::size_t alignment)
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+        if(size == 0)
+            size = 1;
+
+        void* pointer = alignment > alignof(std::max_align_t) ? std::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1)) : std::malloc(size);
+
+        if(pointer == nullptr)
+            throw std::bad_alloc();
+
+        return pointer;
+    }
+}
+
+// The array and nothrow forms forward to these in libstdc++ and libc++
+void* operator new(std::size_t size)
+{
+    return countedAllocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+bool Allocations::isCounting()
+{
+    return true;
+}
+
+uint64_t Allocations::getCount()
+{
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+#else
+
+bool Allocations::isCounting()
+{
+    return false;
+}
+
+uint64_t Allocations::getCount()
+{
+    return 0;
+}
+
+#endif
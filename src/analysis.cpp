@@ -0,0 +1,294 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "analysis.h"
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+#include "instruction.h"
+#include "parser.h"
+#include "trace.h"
+
+namespace
+{
+    std::mutex cacheMutex;
+
+    std::unordered_map<uint64_t, std::shared_ptr<const Analysis>> cache; // Keyed by ROM hash
+}
+
+Analysis::Analysis() : romHash(0)
+{
+    this->kinds.fill(Kind::Unknown);
+}
+
+std::shared_ptr<const Analysis> Analysis::get(Memory& memory)
+{
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+
+        const auto cached = cache.find(memory.romHash);
+
+        if(cached != cache.end())
+            return cached->second;
+    }
+
+    std::shared_ptr<Analysis> analysis = std::make_shared<Analysis>();
+
+    analysis->romHash = memory.romHash;
+    analysis->analyse(memory.getData(), CPU::pcStart + std::min<size_t>(memory.romSize, Memory::memorySize - CPU::pcStart));
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    return cache.emplace(memory.romHash, std::move(analysis)).first->second;
+}
+
+std::shared_ptr<const Analysis> Analysis::get(const uint8_t* rom, size_t size)
+{
+    static_assert(Memory::memorySize <= 4096, "The image below is sized for the original address space");
+
+    std::array<uint8_t, Memory::memorySize> image {};
+
+    size = std::min<size_t>(size, Memory::memorySize - CPU::pcStart);
+
+    std::copy(rom, rom + size, image.begin() + CPU::pcStart);
+
+    const uint64_t hash = Memory::hashROM(rom, size);
+
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+
+        const auto cached = cache.find(hash);
+
+        if(cached != cache.end())
+            return cached->second;
+    }
+
+    std::shared_ptr<Analysis> analysis = std::make_shared<Analysis>();
+
+    analysis->romHash = hash;
+    analysis->analyse(image.data(), CPU::pcStart + size);
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    return cache.emplace(hash, std::move(analysis)).first->second;
+}
+
+void Analysis::analyse(const uint8_t* memory, uint16_t end)
+{
+    TRACE_ZONE("Analysis::analyse");
+
+    std::vector<uint16_t> pending {CPU::pcStart};
+
+    std::vector<bool> leaders(Memory::memorySize, false); // Addresses a block must start at
+
+    leaders[CPU::pcStart] = true;
+
+    auto addTarget = [&](uint16_t target)
+    {
+        if(target + 1 >= end || target < CPU::pcStart)
+            return;
+
+        leaders[target] = true;
+
+        pending.push_back(target);
+    };
+
+    // Recursive descent, with the recursion kept on an explicit worklist
+    while(!pending.empty())
+    {
+        uint16_t address = pending.back();
+
+        pending.pop_back();
+
+        while(address + 1 < end && this->kinds[address] != Kind::Code)
+        {
+            Instruction instruction(memory[address] << 8 | memory[address + 1]);
+
+            instruction.opcode = Parser::parse(instruction);
+
+            // Words that aren't instructions end the path, the bytes stay data
+            if(instruction.opcode == Opcode::Invalid)
+                break;
+
+            this->kinds[address] = Kind::Code;
+
+            if(this->kinds[address + 1] == Kind::Unknown || this->kinds[address + 1] == Kind::Data)
+                this->kinds[address + 1] = Kind::Operand;
+
+            const uint16_t next = address + 2;
+
+            bool fallsThrough = true;
+
+            switch(instruction.opcode)
+            {
+                case Opcode::O1NNN:
+                    addTarget(instruction.getNNN());
+                    fallsThrough = false;
+                    break;
+
+                case Opcode::O2NNN:
+                    addTarget(instruction.getNNN());
+                    addTarget(next);
+                    fallsThrough = false;
+                    break;
+
+                case Opcode::O00EE:
+                    fallsThrough = false;
+                    break;
+
+                case Opcode::OBNNN:
+                    // Only the V0 = 0 target is known, it's usually the start of a jump table
+                    addTarget(instruction.getNNN());
+                    fallsThrough = false;
+                    break;
+
+                case Opcode::O3XNN:
+                case Opcode::O4XNN:
+                case Opcode::O5XY0:
+                case Opcode::O9XY0:
+                case Opcode::OEX9E:
+                case Opcode::OEXA1:
+                    addTarget(next);
+                    addTarget(next + 2);
+                    fallsThrough = false;
+                    break;
+
+                case Opcode::OANNN:
+                    if(instruction.getNNN() < end && this->kinds[instruction.getNNN()] == Kind::Unknown)
+                        this->kinds[instruction.getNNN()] = Kind::Data;
+                    break;
+
+                default:
+                    break;
+            }
+
+            if(!fallsThrough)
+            {
+                // Whatever follows a control transfer starts a new block if it turns out to be code
+                if(next < Memory::memorySize)
+                    leaders[next] = true;
+
+                break;
+            }
+
+            address = next;
+        }
+    }
+
+    // Split the reached instructions into blocks at leaders and after control transfers
+    this->blocks.clear();
+
+    for(uint16_t address = CPU::pcStart; address + 1 < end;)
+    {
+        if(this->kinds[address] != Kind::Code)
+        {
+            ++address;
+            continue;
+        }
+
+        Block block {address, address, {}, false, false};
+
+        for(;;)
+        {
+            Instruction instruction(memory[address] << 8 | memory[address + 1]);
+
+            instruction.opcode = Parser::parse(instruction);
+
+            const uint16_t next = address + 2;
+
+            block.end = next;
+
+            bool ends = true;
+
+            switch(instruction.opcode)
+            {
+                case Opcode::O1NNN:
+                    block.successors = {instruction.getNNN()};
+                    break;
+
+                case Opcode::O2NNN:
+                    block.successors = {instruction.getNNN(), next};
+                    break;
+
+                case Opcode::O00EE:
+                    block.returns = true;
+                    break;
+
+                case Opcode::OBNNN:
+                    block.successors = {instruction.getNNN()};
+                    block.indirect = true;
+                    break;
+
+                case Opcode::O3XNN:
+                case Opcode::O4XNN:
+                case Opcode::O5XY0:
+                case Opcode::O9XY0:
+                case Opcode::OEX9E:
+                case Opcode::OEXA1:
+                    block.successors = {next, static_cast<uint16_t>(next + 2)};
+                    break;
+
+                default:
+                    ends = false;
+                    break;
+            }
+
+            address = next;
+
+            if(ends)
+                break;
+
+            // Falling into another block's leader, or off the end of the reached code
+            if(address + 1 >= end || this->kinds[address] != Kind::Code || leaders[address])
+            {
+                if(address + 1 < end && this->kinds[address] == Kind::Code)
+                    block.successors = {address};
+
+                break;
+            }
+        }
+
+        this->blocks.push_back(std::move(block));
+    }
+}
+
+Analysis::Kind Analysis::getKind(uint16_t address) const
+{
+    return this->kinds[address & (Memory::memorySize - 1)];
+}
+
+bool Analysis::isCode(uint16_t address) const
+{
+    return this->getKind(address) == Kind::Code;
+}
+
+const std::vector<Analysis::Block>& Analysis::getBlocks() const
+{
+    return this->blocks;
+}
+
+const Analysis::Block* Analysis::findBlock(uint16_t address) const
+{
+    const auto block = std::upper_bound(this->blocks.begin(), this->blocks.end(), address, [](uint16_t address, const Block& block) { return address < block.start; });
+
+    if(block == this->blocks.begin())
+        return nullptr;
+
+    const Block& candidate = *(block - 1);
+
+    return address < candidate.end ? &candidate : nullptr;
+}
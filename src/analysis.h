@@ -0,0 +1,79 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "memory.h"
+
+// Static control-flow analysis of a ROM. Starting at the entry point it follows jumps, calls, skips
+// and returns to find which bytes are instructions, splits them into basic blocks and records the
+// edges between them. Everything never reached is data, whatever its alignment.
+
+class Analysis
+{
+    public:
+        enum class Kind : uint8_t
+        {
+            Unknown, // Never reached, shown as data
+            Code, // First byte of an instruction
+            Operand, // Second byte of an instruction
+            Data, // Loaded into I by an LD I, NNN in reached code
+        };
+
+        struct Block
+        {
+            uint16_t start;
+            uint16_t end; // Exclusive
+
+            std::vector<uint16_t> successors;
+
+            bool indirect; // Ends in JP V0, NNN, whose other targets depend on V0
+            bool returns; // Ends in RET
+        };
+
+    private:
+        std::array<Kind, Memory::memorySize> kinds;
+
+        std::vector<Block> blocks; // Sorted by start address
+
+    public:
+        uint64_t romHash;
+
+    private:
+        void analyse(const uint8_t* memory, uint16_t end);
+
+    public:
+        Analysis();
+
+        // Analyses the program in memory, reusing an earlier result for the same ROM hash
+        static std::shared_ptr<const Analysis> get(Memory& memory);
+
+        // As above for a ROM image that isn't loaded into a Memory, as the command line tools have
+        static std::shared_ptr<const Analysis> get(const uint8_t* rom, size_t size);
+
+        Kind getKind(uint16_t address) const;
+
+        bool isCode(uint16_t address) const; // True for the first byte of a reached instruction
+
+        const std::vector<Block>& getBlocks() const;
+
+        const Block* findBlock(uint16_t address) const; // Block containing the address, nullptr for data
+};
@@ -16,14 +16,21 @@
 
 #include "app.h"
 #include "display.h"
+#include "trace.h"
 #include <SDL2/SDL_render.h>
+#include <algorithm>
+#include <cmath>
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "../deps/stb_image_write.h"
 
-App::App() : quit(false), keys(nullptr), window(nullptr), renderer(nullptr), texture(nullptr)
+App::App() : keys(0), frameKeys(0), keyEventCount(0), intervalStart(0), window(nullptr), renderer(nullptr), texture(nullptr), profiler(App::frameTime), presentRunAhead(false), quit(false), fastForward(false), fastForwardRate(4), emulationSpeed(0.0f), fastForwardHeld(false), speedFrames(0), activeFrames(0)
 {
     this->loadMedia();
+
+    this->chip8.history = &this->history;
+
+    this->speedStart = std::chrono::steady_clock::now();
 }
 
 App::~App()
@@ -53,6 +60,8 @@ void App::freeMedia()
 
 void App::screenshot()
 {
+    TRACE_ZONE("App::screenshot");
+
     stbi_write_jpg("capture.png", Display::displayWidth, Display::displayHeight, 4, this->chip8.display.getData(), Display::displayWidth * 4);
 
     this->takeScreenshot = false;
@@ -64,6 +73,8 @@ void App::start(const char* romPath)
     
     srand(time(nullptr));
 
+    this->chip8.reset(false); // Reseeds the CPU's RND generator from the seeded rand()
+
     GUI::init(this->window, this->renderer);
 }
 
@@ -72,6 +83,11 @@ void App::eventLoop()
     SDL_Event event;
 	while(SDL_PollEvent(&event) != 0)
 	{
+        this->activeFrames = App::wakeFrames;
+
+        if((event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) && !event.key.repeat)
+            this->queueKey(event.key.keysym.scancode, event.type == SDL_KEYDOWN, event.key.timestamp);
+
 		switch(event.type)
 		{
 			case SDL_QUIT:
@@ -85,9 +101,24 @@ void App::eventLoop()
 						this->quit = true;
 						break;
 
+                    case SDLK_TAB:
+                        if(!GUI::isROMInputActive)
+                            this->fastForwardHeld = true;
+                        break;
+
+                    case SDLK_t:
+                        if(!GUI::isROMInputActive)
+                            this->fastForward = !this->fastForward;
+                        break;
+
                     case SDLK_p:
                         if(!GUI::showSettings)
-                            this->chip8.paused = !this->chip8.paused;
+                        {
+                            if(this->chip8.paused)
+                                this->chip8.resume();
+                            else
+                                this->chip8.paused = true;
+                        }
                         break;
 
                     case SDLK_m:
@@ -95,6 +126,11 @@ void App::eventLoop()
                             GUI::showSettings = !GUI::showSettings;
                         break;
 
+                    case SDLK_o:
+                        if(!GUI::isROMInputActive)
+                            GUI::showFrameTimes = !GUI::showFrameTimes;
+                        break;
+
                     case SDLK_n:
                         if(!GUI::isROMInputActive)
                             GUI::showDebugWindows = !GUI::showDebugWindows;
@@ -114,17 +150,99 @@ void App::eventLoop()
                         break;
 				}
 				break;
+
+            case SDL_KEYUP:
+                if(event.key.keysym.sym == SDLK_TAB)
+                    this->fastForwardHeld = false;
+                break;
 		}
 
         GUI::processEvent(event);
 	}
 }
 
+void App::queueKey(SDL_Scancode scancode, bool pressed, Uint32 timestamp)
+{
+    const int8_t key = Keypad::getKey(scancode);
+
+    if(key < 0)
+        return;
+
+    const uint16_t keys = pressed ? this->keys | (1 << key) : this->keys & ~(1 << key);
+
+    if(keys == this->keys)
+        return;
+
+    this->keys = keys;
+
+    if(pressed)
+        this->latency.tag(timestamp, this->getPresentedDisplay());
+
+    // A full queue folds the rest into its last event, keeping the final state
+    if(this->keyEventCount == Chip8::maxKeyEvents)
+    {
+        this->keyEvents[this->keyEventCount - 1].keys = keys;
+        return;
+    }
+
+    this->keyEvents[this->keyEventCount] = {0, keys};
+    this->keyTimestamps[this->keyEventCount] = timestamp;
+
+    ++this->keyEventCount;
+}
+
 void App::update()
 {
-    this->keys = SDL_GetKeyboardState(nullptr);
+    TRACE_ZONE("App::update");
+
+    if(this->activeFrames > 0)
+        --this->activeFrames;
+
+    // Events from the last host interval are spread over this frame's instructions at the same relative times
+    const Uint32 intervalEnd = SDL_GetTicks();
+    const Uint32 interval = std::max<Uint32>(intervalEnd - this->intervalStart, 1);
+
+    for(uint8_t i = 0; i < this->keyEventCount; ++i)
+    {
+        const Uint32 offset = std::min(this->keyTimestamps[i] - std::min(this->keyTimestamps[i], this->intervalStart), interval - 1);
+
+        this->keyEvents[i].instruction = offset * this->chip8.instructionsPerSecond / interval;
+    }
+
+    this->intervalStart = intervalEnd;
+
+    const uint64_t instructionCount = this->chip8.instructionCount;
+    const uint64_t frameCount = this->chip8.frameCount;
+    const bool beginsFrame = this->chip8.frameInstruction == 0;
+
+    this->perfCounters.beginFrame();
+
+    this->emulateFrame(this->frameKeys, this->keyEvents.data(), this->keyEventCount);
+
+    // Paused or mid-frame, the queued events are dropped and only the final mask carries over
+    if(beginsFrame && this->chip8.frameCount != frameCount)
+        this->latency.consume(frameCount);
+    else if(this->keyEventCount > 0)
+        this->latency.discard();
+
+    this->frameKeys = this->keys;
+    this->keyEventCount = 0;
+
+    this->perfCounters.endFrame(Chip8::executionCore, this->chip8.instructionCount - instructionCount);
+
+    if(this->isFastForwarding())
+        this->runFastForward();
 
-    this->chip8.emulateCycle(this->keys);
+    const auto now = std::chrono::steady_clock::now();
+    const float elapsed = std::chrono::duration<float>(now - this->speedStart).count();
+
+    if(elapsed >= 1.0f)
+    {
+        this->emulationSpeed = (this->chip8.frameCount - this->speedFrames) / elapsed * App::frameTime / 1000.0f;
+
+        this->speedStart = now;
+        this->speedFrames = this->chip8.frameCount;
+    }
 
     if(!this->takeScreenshot)
         return;
@@ -132,15 +250,100 @@ void App::update()
     this->screenshot();
 }
 
+Display& App::getPresentedDisplay()
+{
+    return this->presentRunAhead ? this->runAheadDisplay : this->chip8.display;
+}
+
+bool App::isFastForwarding()
+{
+    return (this->fastForward || this->fastForwardHeld) && !this->chip8.paused && this->chip8.memory.romLoaded;
+}
+
+void App::runFastForward()
+{
+    TRACE_ZONE("App::runFastForward");
+
+    if(this->fastForwardRate > 0)
+    {
+        for(uint8_t i = 1; i < this->fastForwardRate && !this->chip8.paused; ++i)
+            this->emulateFrame(this->keys);
+
+        return;
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<float, std::milli>(App::frameTime * App::uncappedBudget);
+
+    while(!this->chip8.paused && std::chrono::steady_clock::now() < deadline)
+        this->emulateFrame(this->keys);
+}
+
+void App::emulateFrame(uint16_t keys, const Chip8::KeyEvent* events, uint8_t eventCount)
+{
+    this->chip8.emulateCycle(keys, events, eventCount);
+
+    this->autoSpeed.observe(this->chip8);
+}
+
+void App::runAhead()
+{
+    // Frames are already far ahead of the input while fast-forwarding
+    if(this->isFastForwarding())
+    {
+        this->presentRunAhead = false;
+        return;
+    }
+
+    this->presentRunAhead = this->chip8.runAhead(this->keys, this->runAheadDisplay);
+}
+
 void App::draw()
 {
+    TRACE_ZONE("App::draw");
+
     SDL_RenderClear(this->renderer);
 
-    SDL_UpdateTexture(this->texture, nullptr, this->chip8.display.getData(), sizeof(this->chip8.display[0]) * Display::displayWidth);
+    Display& display = this->getPresentedDisplay();
+
+    SDL_UpdateTexture(this->texture, nullptr, display.getData(), sizeof(display[0]) * Display::displayWidth);
 
     SDL_RenderCopy(this->renderer, this->texture, nullptr, nullptr);
 
-    GUI::draw(this->renderer, this->chip8, this->chip8.instructionsPerSecond, this->takeScreenshot);
+    this->profiler.endPhase(Profiler::Phase::Render);
+
+    GUI::draw(this->renderer, this->chip8, this->history, this->profiler, this->perfCounters, this->latency, this->autoSpeed, this->chip8.instructionsPerSecond, this->fastForward, this->fastForwardRate, this->isFastForwarding() ? this->emulationSpeed : 0.0f, this->takeScreenshot);
+
+    this->profiler.endPhase(Profiler::Phase::GUI);
 
     SDL_RenderPresent(this->renderer);
+
+    this->latency.present(this->chip8.frameCount, display, SDL_GetTicks());
+
+    this->profiler.endPhase(Profiler::Phase::Present);
+}
+
+bool App::isVisible()
+{
+    return (SDL_GetWindowFlags(this->window) & (SDL_WINDOW_MINIMIZED | SDL_WINDOW_HIDDEN)) == 0;
+}
+
+bool App::isIdle()
+{
+    if(this->activeFrames > 0)
+        return false;
+
+    return this->chip8.paused || !this->chip8.memory.romLoaded || this->chip8.isBlocked();
+}
+
+int App::getWaitTimeout(float elapsed)
+{
+    // Nothing can change without input, so only the GUI needs an occasional tick
+    if(this->isIdle())
+        return App::idleWaitTimeout;
+
+    // The ROM keeps running off screen, sleep until the frame's deadline instead of spinning for it
+    if(!this->isVisible() && elapsed < App::frameTime)
+        return static_cast<int>(std::ceil(App::frameTime - elapsed));
+
+    return 0;
 }
@@ -18,23 +18,61 @@
 
 #include <SDL2/SDL.h>
 #include <SDL_render.h>
+#include <chrono>
 #include <cstdlib>
 
 #include "chip8.h"
+#include "autospeed.h"
+#include "history.h"
 #include "gui.h"
+#include "latency.h"
+#include "profiler.h"
+#include "perfcounters.h"
 
 class App
 {
     private:
-        const Uint8* keys;
+        uint16_t keys; // Keypad mask after every queued event
+
+        uint16_t frameKeys; // Keypad mask when the queued events began
+
+        std::array<Chip8::KeyEvent, Chip8::maxKeyEvents> keyEvents; // Instruction fields are filled in by update
+        std::array<Uint32, Chip8::maxKeyEvents> keyTimestamps;
+        uint8_t keyEventCount;
+
+        Uint32 intervalStart; // SDL ticks when the events for the next frame started being collected
 
         SDL_Window* window;
         SDL_Renderer* renderer;
         SDL_Texture* texture;
 
+    public:
+        static constexpr float frameTime = 16.6;
+
+        static constexpr int idleWaitTimeout = 250; // Milliseconds, keeps the GUI ticking while nothing else happens
+
+        static constexpr uint8_t wakeFrames = 3; // Frames drawn at full rate after input so ImGui can settle
+
+        static constexpr float uncappedBudget = 0.75f; // Share of a host frame uncapped fast-forward spends emulating
+
     public:
         Chip8 chip8;
 
+        History history; // Snapshots and input for reverse stepping in the debugger
+
+        Profiler profiler;
+
+        PerfCounters perfCounters;
+
+        Latency latency;
+
+        AutoSpeed autoSpeed; // Picks and remembers instructionsPerSecond per ROM
+
+    private:
+        Display runAheadDisplay; // The speculative frame presented instead of the real one
+
+        bool presentRunAhead;
+
     private:
         void loadMedia();
         void freeMedia();
@@ -44,9 +82,34 @@ class App
 
         bool takeScreenshot;
 
+        bool fastForward; // Toggled from the GUI or with T
+
+        uint8_t fastForwardRate; // Emulated frames per host frame while fast-forwarding, 0 for uncapped
+
+        float emulationSpeed; // Emulated frames per second over the last second, as a multiple of real time
+
+    private:
+        bool fastForwardHeld; // Tab is down
+
+        std::chrono::steady_clock::time_point speedStart;
+        uint64_t speedFrames; // chip8.frameCount at speedStart
+
+    private:
+        uint8_t activeFrames; // Frames left before the loop may idle again
+
     private:
         void screenshot();
 
+        void queueKey(SDL_Scancode scancode, bool pressed, Uint32 timestamp);
+
+        Display& getPresentedDisplay();
+
+        bool isFastForwarding();
+
+        void runFastForward(); // Emulates the extra frames of a fast-forwarding host frame
+
+        void emulateFrame(uint16_t keys, const Chip8::KeyEvent* events = nullptr, uint8_t eventCount = 0);
+
     public:
         App();
         ~App();
@@ -54,5 +117,12 @@ class App
         void start(const char* romPath);
         void eventLoop();
         void update();
+        void runAhead();
         void draw();
+
+        bool isVisible(); // False while minimized or hidden
+
+        bool isIdle(); // Paused, ROM-less or key-blocked, nothing changes until input arrives
+
+        int getWaitTimeout(float elapsed); // Milliseconds the main loop may block on input given the time since the last frame, 0 to run now
 };
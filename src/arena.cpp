@@ -0,0 +1,72 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "arena.h"
+#include <cstdarg>
+#include <cstdio>
+
+FrameArena::FrameArena() : used(0), highWater(0), failedAllocations(0)
+{
+}
+
+void FrameArena::reset()
+{
+    this->used = 0;
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+    const size_t start = (this->used + alignment - 1) & ~(alignment - 1);
+
+    if(start + size > FrameArena::arenaSize)
+    {
+        ++this->failedAllocations;
+
+        return nullptr;
+    }
+
+    this->used = start + size;
+
+    if(this->used > this->highWater)
+        this->highWater = this->used;
+
+    return this->buffer.data() + start;
+}
+
+const char* FrameArena::format(const char* format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    const int length = std::vsnprintf(nullptr, 0, format, args);
+    va_end(args);
+
+    char* text = length < 0 ? nullptr : this->allocate<char>(length + 1);
+
+    if(text == nullptr)
+        return "";
+
+    va_start(args, format);
+    std::vsnprintf(text, length + 1, format, args);
+    va_end(args);
+
+    return text;
+}
+
+size_t FrameArena::getUsed() const
+{
+    return this->used;
+}
@@ -0,0 +1,57 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <stdint.h>
+#include <cstddef>
+#include <array>
+
+// Bump allocator for temporaries that only live until the end of the frame.
+// Nothing is freed individually, reset() releases everything at once.
+
+class FrameArena
+{
+    public:
+        static constexpr size_t arenaSize = 256 * 1024;
+
+    private:
+        alignas(std::max_align_t) std::array<unsigned char, FrameArena::arenaSize> buffer;
+
+        size_t used;
+
+    public:
+        size_t highWater; // Largest number of bytes used in a single frame
+
+        uint32_t failedAllocations; // Requests that did not fit since construction
+
+    public:
+        FrameArena();
+
+        void reset();
+
+        void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+        template<typename T>
+        T* allocate(size_t count)
+        {
+            return static_cast<T*>(this->allocate(sizeof(T) * count, alignof(T)));
+        }
+
+        const char* format(const char* format, ...); // printf into the arena, returns "" when full
+
+        size_t getUsed() const;
+};
@@ -0,0 +1,220 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "autospeed.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+AutoSpeed::AutoSpeed(const char* path) : path(path), romHash(0), ips(0), startIPS(0), doublings(0), frames(0), idleFrames(0), firstDrawBatches(0), firstFrames(0), frameCount(0), instructionCount(0), skippedInstructions(0), drawCount(0), drawBatchCount(0), enabled(true), status(Status::Off), drawsPerFrame(0.0f)
+{
+    std::FILE* file = std::fopen(path, "r");
+
+    if(file == nullptr)
+        return;
+
+    unsigned long long hash;
+    unsigned int speed;
+
+    while(std::fscanf(file, "%llx %u", &hash, &speed) == 2)
+        this->speeds[hash] = std::clamp<unsigned int>(speed, AutoSpeed::minimumIPS, AutoSpeed::maximumIPS);
+
+    std::fclose(file);
+}
+
+void AutoSpeed::observe(Chip8& chip8)
+{
+    if(!this->enabled || !chip8.memory.romLoaded)
+    {
+        this->status = Status::Off;
+        this->romHash = 0;
+        return;
+    }
+
+    if(chip8.memory.romHash != this->romHash)
+    {
+        this->begin(chip8);
+        return;
+    }
+
+    if(this->status != Status::Tuning)
+        return;
+
+    if(chip8.instructionsPerSecond != this->ips)
+    {
+        this->status = Status::Manual;
+        return;
+    }
+
+    // Idle time is only visible through the idle-skipping loop, so without it tuning stops and gives the starting speed back
+    if(!chip8.skipIdleLoops)
+    {
+        chip8.instructionsPerSecond = this->startIPS;
+
+        this->status = Status::Off;
+        return;
+    }
+
+    // Only single whole frames show their idle time, and a ROM waiting for a key isn't playing yet
+    const bool measurable = chip8.frameCount - this->frameCount == 1 && !chip8.waitingForKey && !chip8.recorder.isRecording() && !chip8.breakpoints.isActive() && !chip8.watchpoints.isActive();
+
+    if(measurable)
+    {
+        const uint64_t executed = (chip8.instructionCount - this->instructionCount) - (chip8.skippedInstructions - this->skippedInstructions);
+
+        this->busy[this->frames] = std::min<uint64_t>(executed, UINT8_MAX);
+
+        if(executed < this->ips)
+            ++this->idleFrames;
+
+        this->drawsPerFrame += (static_cast<float>(chip8.drawCount - this->drawCount) - this->drawsPerFrame) / (this->frames + 1);
+
+        if(this->doublings == 0)
+        {
+            this->firstDrawBatches += chip8.drawBatchCount - this->drawBatchCount;
+            ++this->firstFrames;
+        }
+
+        ++this->frames;
+    }
+
+    this->frameCount = chip8.frameCount;
+    this->instructionCount = chip8.instructionCount;
+    this->skippedInstructions = chip8.skippedInstructions;
+    this->drawCount = chip8.drawCount;
+    this->drawBatchCount = chip8.drawBatchCount;
+
+    if(this->frames == AutoSpeed::observedFrames)
+        this->evaluate(chip8);
+}
+
+uint16_t AutoSpeed::getProgress() const
+{
+    return this->frames;
+}
+
+void AutoSpeed::forget(Chip8& chip8)
+{
+    this->speeds.erase(chip8.memory.romHash);
+
+    this->save();
+
+    this->begin(chip8);
+}
+
+void AutoSpeed::begin(Chip8& chip8)
+{
+    this->romHash = chip8.memory.romHash;
+
+    const auto stored = this->speeds.find(this->romHash);
+
+    if(stored != this->speeds.end())
+    {
+        chip8.instructionsPerSecond = stored->second;
+
+        this->status = Status::Stored;
+        return;
+    }
+
+    this->startIPS = chip8.instructionsPerSecond;
+    this->ips = chip8.instructionsPerSecond;
+    this->doublings = 0;
+    this->firstDrawBatches = 0;
+    this->firstFrames = 0;
+
+    this->status = Status::Tuning;
+
+    this->restart(chip8);
+}
+
+void AutoSpeed::restart(Chip8& chip8)
+{
+    this->frames = 0;
+    this->idleFrames = 0;
+    this->drawsPerFrame = 0.0f;
+
+    this->frameCount = chip8.frameCount;
+    this->instructionCount = chip8.instructionCount;
+    this->skippedInstructions = chip8.skippedInstructions;
+    this->drawCount = chip8.drawCount;
+    this->drawBatchCount = chip8.drawBatchCount;
+}
+
+void AutoSpeed::evaluate(Chip8& chip8)
+{
+    // Timer-paced, the slowest frames' work plus headroom is all the game needs
+    if(this->idleFrames * 2 >= this->frames)
+    {
+        std::array<uint8_t, AutoSpeed::observedFrames> sorted = this->busy;
+
+        std::sort(sorted.begin(), sorted.end());
+
+        const uint8_t slowest = sorted[AutoSpeed::observedFrames * 95 / 100];
+
+        this->finish(chip8, static_cast<uint8_t>(std::min(std::ceil(slowest * AutoSpeed::headroom), static_cast<float>(AutoSpeed::maximumIPS))));
+        return;
+    }
+
+    // Busy every frame may just mean too slow to finish a frame's work, so look again with more room
+    if(this->doublings < AutoSpeed::maxDoublings && this->ips < AutoSpeed::maximumIPS)
+    {
+        ++this->doublings;
+
+        this->ips = std::min<uint16_t>(this->ips * 2, AutoSpeed::maximumIPS);
+
+        chip8.instructionsPerSecond = this->ips;
+
+        this->restart(chip8);
+        return;
+    }
+
+    // Never idle, so pace by redraws instead
+    if(this->firstDrawBatches == 0)
+    {
+        this->finish(chip8, this->startIPS);
+        return;
+    }
+
+    const float instructionsPerRedraw = static_cast<float>(this->startIPS) * this->firstFrames / this->firstDrawBatches;
+
+    this->finish(chip8, static_cast<uint8_t>(std::min(std::ceil(instructionsPerRedraw), static_cast<float>(AutoSpeed::maximumIPS))));
+}
+
+void AutoSpeed::finish(Chip8& chip8, uint8_t target)
+{
+    target = std::clamp(target, AutoSpeed::minimumIPS, AutoSpeed::maximumIPS);
+
+    chip8.instructionsPerSecond = target;
+
+    this->speeds[this->romHash] = target;
+
+    this->save();
+
+    this->status = Status::Tuned;
+}
+
+void AutoSpeed::save()
+{
+    std::FILE* file = std::fopen(this->path.c_str(), "w");
+
+    if(file == nullptr)
+        return;
+
+    for(const auto& [hash, speed] : this->speeds)
+        std::fprintf(file, "%016llx %u\n", static_cast<unsigned long long>(hash), static_cast<unsigned int>(speed));
+
+    std::fclose(file);
+}
@@ -0,0 +1,107 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <string>
+#include <unordered_map>
+
+#include "chip8.h"
+
+// Picks instructionsPerSecond for each ROM from how it spends its frames, and remembers the
+// choice per ROM hash. Timer-paced games idle once their frame's work is done, so the busy part
+// of their frames says how many instructions they need. Games that never idle are taken to be
+// paced by their redraws, and get enough instructions for one redraw per frame as on the VIP.
+
+class AutoSpeed
+{
+    public:
+        enum class Status : uint8_t
+        {
+            Off,
+            Tuning,
+            Stored, // Taken from an earlier launch
+            Tuned,
+            Manual, // The user changed the speed while tuning
+        };
+
+        static constexpr uint16_t observedFrames = 180; // Three seconds of frames that weren't waiting for a key
+
+        static constexpr uint8_t maxDoublings = 2; // Speed-ups tried on games that never idle
+
+        static constexpr float headroom = 1.25f;
+
+        static constexpr uint8_t minimumIPS = 4;
+        static constexpr uint8_t maximumIPS = 200;
+
+        static constexpr const char* defaultPath = "speeds.cfg";
+
+    private:
+        std::unordered_map<uint64_t, uint8_t> speeds; // instructionsPerSecond by ROM hash
+
+        std::string path;
+
+        uint64_t romHash;
+
+        uint8_t ips; // Speed being observed
+
+        uint8_t startIPS; // Speed before tuning began
+
+        uint8_t doublings;
+
+        std::array<uint8_t, AutoSpeed::observedFrames> busy; // Instructions each observed frame ran before it idled
+        uint16_t frames;
+        uint16_t idleFrames;
+
+        uint64_t firstDrawBatches; // Redraws during the first window, at startIPS
+        uint16_t firstFrames;
+
+        // Counters at the previous observation
+        uint64_t frameCount;
+        uint64_t instructionCount;
+        uint64_t skippedInstructions;
+        uint64_t drawCount;
+        uint64_t drawBatchCount;
+
+    private:
+        void begin(Chip8& chip8);
+
+        void restart(Chip8& chip8);
+
+        void finish(Chip8& chip8, uint8_t target);
+
+        void evaluate(Chip8& chip8);
+
+        void save();
+
+    public:
+        bool enabled;
+
+        Status status;
+
+        float drawsPerFrame; // DXYN per observed frame in the current window
+
+    public:
+        AutoSpeed(const char* path = AutoSpeed::defaultPath);
+
+        void observe(Chip8& chip8); // Call after every emulateCycle
+
+        uint16_t getProgress() const; // Frames observed in the current window
+
+        void forget(Chip8& chip8); // Drops the stored speed of the loaded ROM and tunes again
+};
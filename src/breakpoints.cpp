@@ -0,0 +1,124 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "breakpoints.h"
+#include <utility>
+
+Breakpoints::Breakpoints() : bits{}, count(0), conditionBits{}, temporaryActive(false), temporaryAddress(0), temporaryDepth(0)
+{
+
+}
+
+void Breakpoints::set(uint16_t address)
+{
+    if(this->test(address))
+        return;
+
+    address &= Breakpoints::addressCount - 1;
+
+    this->bits[address >> 6] |= uint64_t(1) << (address & 63);
+
+    ++this->count;
+}
+
+void Breakpoints::clear(uint16_t address)
+{
+    if(!this->test(address))
+        return;
+
+    address &= Breakpoints::addressCount - 1;
+
+    this->bits[address >> 6] &= ~(uint64_t(1) << (address & 63));
+    this->conditionBits[address >> 6] &= ~(uint64_t(1) << (address & 63));
+
+    this->conditions.erase(address);
+
+    --this->count;
+}
+
+void Breakpoints::toggle(uint16_t address)
+{
+    if(this->test(address))
+        this->clear(address);
+    else
+        this->set(address);
+}
+
+void Breakpoints::clearAll()
+{
+    this->bits.fill(0);
+    this->conditionBits.fill(0);
+
+    this->conditions.clear();
+
+    this->count = 0;
+}
+
+uint16_t Breakpoints::getCount() const
+{
+    return this->count;
+}
+
+bool Breakpoints::setCondition(uint16_t address, const std::string& source, std::string& error)
+{
+    address &= Breakpoints::addressCount - 1;
+
+    if(source.find_first_not_of(" \t") == std::string::npos)
+    {
+        this->conditionBits[address >> 6] &= ~(uint64_t(1) << (address & 63));
+
+        this->conditions.erase(address);
+
+        this->set(address);
+
+        return true;
+    }
+
+    Condition condition;
+
+    if(!condition.compile(source))
+    {
+        error = condition.error;
+        return false;
+    }
+
+    this->conditions[address] = std::move(condition);
+
+    this->conditionBits[address >> 6] |= uint64_t(1) << (address & 63);
+
+    this->set(address);
+
+    return true;
+}
+
+const Condition* Breakpoints::getCondition(uint16_t address) const
+{
+    const auto condition = this->conditions.find(address & (Breakpoints::addressCount - 1));
+
+    return condition == this->conditions.end() ? nullptr : &condition->second;
+}
+
+void Breakpoints::setTemporary(uint16_t address, uint16_t depth)
+{
+    this->temporaryActive = true;
+    this->temporaryAddress = address;
+    this->temporaryDepth = depth;
+}
+
+void Breakpoints::clearTemporary()
+{
+    this->temporaryActive = false;
+}
@@ -0,0 +1,98 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <string>
+#include <unordered_map>
+
+#include "condition.h"
+
+class Breakpoints
+{
+    public:
+        static constexpr uint16_t addressCount = 4096;
+
+        static constexpr uint16_t anyDepth = 0xFFFF; // Temporary stop at any stack depth
+
+    private:
+        std::array<uint64_t, Breakpoints::addressCount / 64> bits; // One bit per address
+
+        uint16_t count; // Addresses with a breakpoint, the execute loop only checks when nonzero
+
+        std::array<uint64_t, Breakpoints::addressCount / 64> conditionBits; // Set where a condition must also hold
+
+        std::unordered_map<uint16_t, Condition> conditions; // Compiled once when set, looked up only on a hit
+
+        bool temporaryActive; // One-shot stop used by step over, step out and run to cursor
+        uint16_t temporaryAddress;
+        uint16_t temporaryDepth; // Stops only once the stack pointer is at or below this
+
+    public:
+        Breakpoints();
+
+        bool isActive() const
+        {
+            return this->count > 0 || this->temporaryActive;
+        }
+
+        bool test(uint16_t address) const
+        {
+            address &= Breakpoints::addressCount - 1;
+
+            return (this->bits[address >> 6] >> (address & 63)) & 1;
+        }
+
+        // A breakpoint at the PC whose condition, if any, holds
+        bool hits(const CPU& cpu, Memory& memory) const
+        {
+            if(!this->test(cpu.pc))
+                return false;
+
+            const uint16_t address = cpu.pc & (Breakpoints::addressCount - 1);
+
+            if(!((this->conditionBits[address >> 6] >> (address & 63)) & 1))
+                return true;
+
+            return this->conditions.at(address).evaluate(cpu, memory);
+        }
+
+        bool shouldStop(const CPU& cpu, Memory& memory) const
+        {
+            return this->hits(cpu, memory) || (this->temporaryActive && cpu.pc == this->temporaryAddress && cpu.sp <= this->temporaryDepth);
+        }
+
+        void set(uint16_t address);
+
+        void clear(uint16_t address);
+
+        void toggle(uint16_t address);
+
+        void clearAll();
+
+        uint16_t getCount() const;
+
+        // Sets a breakpoint that only stops when the expression holds, an empty expression makes it unconditional
+        bool setCondition(uint16_t address, const std::string& source, std::string& error);
+
+        const Condition* getCondition(uint16_t address) const;
+
+        void setTemporary(uint16_t address, uint16_t depth);
+
+        void clearTemporary();
+};
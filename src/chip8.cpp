@@ -15,11 +15,19 @@
 //     along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "chip8.h"
+#include "history.h"
 #include "instructions.h"
+#include "logger.h"
+#include "trace.h"
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
+#include <type_traits>
 
-Chip8::Chip8() : paused(false), instructionsPerSecond(11)
+Chip8::Chip8() : paused(false), instructionsPerSecond(11), instructionCount(0), frameCount(0), frameInstruction(0), skipIdleLoops(true), skippedInstructions(0), runAheadFrames(0), drawCount(0), drawBatchCount(0), history(nullptr), waitingForKey(false), idleLoopTarget(0), idleLoopStart(0), idleLoopClean(false), lastDrawInstruction(0), keyEventCount(0), nextKeyEvent(0), resumeInstruction(UINT64_MAX), recorderState(new State), runAheadState(new State)
 {
+    this->memory.watchpoints = &this->watchpoints;
+
     this->reset(true);
 }
 
@@ -29,6 +37,15 @@ void Chip8::reset(bool resetMemory)
     this->display.clear();
     this->keypad.reset();
 
+    this->waitingForKey = false;
+
+    this->keyEventCount = 0;
+    this->nextKeyEvent = 0;
+
+    // Reverse stepping across a reset would resurrect the old machine
+    if(this->history != nullptr)
+        this->history->clear();
+
     if(!resetMemory)
         return;
 
@@ -36,32 +53,435 @@ void Chip8::reset(bool resetMemory)
     this->memory.loadFont();
 }
 
-void Chip8::emulateCycle(const Uint8* keys)
+void Chip8::emulateCycle(uint16_t keys, const KeyEvent* events, uint8_t eventCount)
 {
+    TRACE_ZONE("Chip8::emulateCycle");
+
     if(!this->memory.romLoaded)
         return;
 
     if(this->paused)
         return;
 
-    this->keypad.update(keys);
+    // A frame left unfinished by the debugger is completed with the keys it started with
+    if(this->frameInstruction == 0)
+        this->beginFrame(keys, events, eventCount);
 
-    for(uint8_t i = 0; i < this->instructionsPerSecond; ++i)
+    // The breakpoint checks live in their own loop so running without breakpoints pays nothing for them
+    if(this->breakpoints.isActive() || this->watchpoints.isActive())
     {
-        Instruction instruction(this->memory.fetchWord(this->cpu.pc));
+        if(!this->runFrameChecked())
+            return;
+    }
+    else if(this->skipIdleLoops && !this->recorder.isRecording())
+        this->runFrameSkippingIdle();
+    else
+    {
+        while(this->frameInstruction < this->instructionsPerSecond)
+        {
+            this->step();
 
-        this->cpu.pc += 2;
+            if(this->waitingForKey && !this->recorder.isRecording())
+                this->parkFrame();
+        }
+    }
 
-        instruction.opcode = Parser::parse(instruction);
+    this->endFrame();
+}
 
-        this->execute(instruction);
+void Chip8::runFrameSkippingIdle()
+{
+    static_assert(std::has_unique_object_representations_v<CPU>, "CPU states are compared bytewise");
+
+    while(this->frameInstruction < this->instructionsPerSecond)
+    {
+        const uint16_t pc = this->cpu.pc;
+        const uint16_t word = this->memory.peekWord(pc);
+
+        // Anything that writes memory or the display, or waits for a key, makes the loop do work
+        if((word & 0xF000) == 0xD000 || word == 0x00E0 || (word & 0xF0FF) == 0xF033 || (word & 0xF0FF) == 0xF055 || (word & 0xF0FF) == 0xF00A)
+            this->idleLoopClean = false;
+
+        this->step();
+
+        if(this->waitingForKey)
+        {
+            this->parkFrame();
+            continue;
+        }
+
+        if((word & 0xF000) != 0x1000 || this->cpu.pc > pc)
+            continue;
+
+        // A backward jump. If a whole iteration since the last one left the CPU unchanged, then nothing
+        // it reads (registers, timers, keys, memory) can change before the frame ends, so every later
+        // iteration this frame is identical and only the instruction count moves.
+        if(this->idleLoopClean && this->cpu.pc == this->idleLoopTarget && std::memcmp(&this->cpu, &this->idleLoopCPU, sizeof(CPU)) == 0)
+        {
+            const uint8_t length = this->frameInstruction - this->idleLoopStart;
+            const uint8_t skipped = (this->getInputBoundary() - this->frameInstruction) / length * length;
+
+            this->frameInstruction += skipped;
+            this->instructionCount += skipped;
+            this->skippedInstructions += skipped;
+
+            continue;
+        }
+
+        this->idleLoopTarget = this->cpu.pc;
+        this->idleLoopStart = this->frameInstruction;
+        this->idleLoopClean = true;
+        this->idleLoopCPU = this->cpu;
     }
 
+    // Timers tick between frames, so a loop is only trusted within one
+    this->idleLoopClean = false;
+}
+
+void Chip8::parkFrame()
+{
+    // Every FX0A retry before the keys change again would fail the same way
+    const uint8_t skipped = this->getInputBoundary() - this->frameInstruction;
+
+    this->frameInstruction += skipped;
+    this->instructionCount += skipped;
+    this->skippedInstructions += skipped;
+}
+
+uint8_t Chip8::getInputBoundary()
+{
+    if(this->nextKeyEvent < this->keyEventCount)
+        return std::min(this->keyEvents[this->nextKeyEvent].instruction, this->instructionsPerSecond);
+
+    return this->instructionsPerSecond;
+}
+
+void Chip8::applyKeyEvents()
+{
+    while(this->nextKeyEvent < this->keyEventCount && this->keyEvents[this->nextKeyEvent].instruction <= this->frameInstruction)
+    {
+        const KeyEvent& event = this->keyEvents[this->nextKeyEvent++];
+
+        this->keypad.updateMask(event.keys);
+    }
+
+    // An iteration that saw the keys change proves nothing about the ones after it
+    this->idleLoopClean = false;
+}
+
+bool Chip8::isBlocked()
+{
+    return this->memory.romLoaded && this->waitingForKey && this->cpu.delayTimer == 0 && this->cpu.soundTimer == 0;
+}
+
+bool Chip8::runFrameChecked()
+{
+    while(this->frameInstruction < this->instructionsPerSecond)
+    {
+        if(this->instructionCount != this->resumeInstruction && this->breakpoints.shouldStop(this->cpu, this->memory))
+        {
+            // Any stop ends a pending step over or run to cursor
+            this->breakpoints.clearTemporary();
+
+            this->paused = true;
+
+            return false;
+        }
+
+        const uint16_t pc = this->cpu.pc;
+
+        this->watchpoints.triggered = false;
+
+        this->step();
+
+        // Watchpoints stop after the access, pointing back at the instruction that made it
+        if(this->watchpoints.triggered)
+        {
+            this->watchpoints.hit.pc = pc;
+
+            this->breakpoints.clearTemporary();
+
+            this->paused = true;
+
+            if(this->frameInstruction >= this->instructionsPerSecond)
+                this->endFrame();
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void Chip8::resume()
+{
+    this->resumeInstruction = this->instructionCount;
+
+    this->paused = false;
+}
+
+void Chip8::stepOver()
+{
+    const Instruction instruction(this->memory.peekWord(this->cpu.pc));
+
+    if(Parser::parse(instruction) != Opcode::O2NNN)
+    {
+        this->advance();
+        return;
+    }
+
+    this->breakpoints.setTemporary(this->cpu.pc + 2, this->cpu.sp);
+
+    this->resume();
+}
+
+void Chip8::stepOut()
+{
+    if(this->cpu.sp == 0)
+        return;
+
+    this->breakpoints.setTemporary(this->cpu.stack.at(this->cpu.sp - 1), this->cpu.sp - 1);
+
+    this->resume();
+}
+
+void Chip8::runTo(uint16_t address)
+{
+    this->breakpoints.setTemporary(address, Breakpoints::anyDepth);
+
+    this->resume();
+}
+
+void Chip8::replayFrame(uint16_t keys, uint8_t instructions, const KeyEvent* events, uint8_t eventCount)
+{
+    if(!this->memory.romLoaded)
+        return;
+
+    this->beginFrame(keys, events, eventCount);
+
+    for(uint8_t i = 0; i < instructions; ++i)
+        this->step();
+
+    this->endFrame();
+}
+
+void Chip8::beginFrame(uint16_t keys, const KeyEvent* events, uint8_t eventCount)
+{
+    eventCount = std::min(eventCount, Chip8::maxKeyEvents);
+
+    std::copy(events, events + eventCount, this->keyEvents.begin());
+
+    this->keyEventCount = eventCount;
+    this->nextKeyEvent = 0;
+
+    // Snapshots are taken before the keypad update so replaying the frame sees the same key transitions
+    if(this->history != nullptr)
+        this->history->beginFrame(*this, keys, events, eventCount);
+
+    // Periodic savestates let the trace index jump anywhere with a short replay
+    if(this->recorder.isRecording() && this->frameCount % Recorder::stateInterval == 0)
+    {
+        this->saveState(*this->recorderState);
+
+        this->recorder.recordState(this->frameCount, this->recorderState.get(), sizeof(State));
+    }
+
+    this->keypad.updateMask(keys);
+
+    if(!this->recorder.isRecording())
+        return;
+
+    this->recorder.recordFrame(this->frameCount, keys, this->instructionsPerSecond, eventCount);
+
+    for(uint8_t i = 0; i < eventCount; ++i)
+        this->recorder.recordKeyEvent(this->frameCount, events[i].keys, events[i].instruction);
+}
+
+void Chip8::advance()
+{
+    if(!this->memory.romLoaded)
+        return;
+
+    if(this->frameInstruction == 0)
+        this->beginFrame(this->keypad.getMask());
+
+    const uint16_t pc = this->cpu.pc;
+
+    this->watchpoints.triggered = false;
+
+    this->step();
+
+    if(this->watchpoints.triggered)
+        this->watchpoints.hit.pc = pc;
+
+    if(this->frameInstruction >= this->instructionsPerSecond)
+        this->endFrame();
+}
+
+void Chip8::step()
+{
+    if(this->nextKeyEvent < this->keyEventCount && this->keyEvents[this->nextKeyEvent].instruction <= this->frameInstruction)
+        this->applyKeyEvents();
+
+    const uint16_t pc = this->cpu.pc;
+
+    Instruction instruction(this->memory.fetchWord(pc));
+
+    this->cpu.pc += 2;
+
+    this->waitingForKey = false;
+
+    instruction.opcode = Parser::parse(instruction);
+
+    if(this->recorder.isRecording())
+        this->executeRecorded(instruction, pc);
+    else
+        this->execute(instruction);
+
+    ++this->instructionCount;
+    ++this->frameInstruction;
+}
+
+void Chip8::saveState(State& state)
+{
+    static_assert(std::is_trivially_copyable<State>::value, "Savestates are copied as raw bytes");
+
+    state.cpu = this->cpu;
+    state.memory = this->memory;
+    state.display = this->display;
+    state.keypad = this->keypad;
+    state.instructionCount = this->instructionCount;
+    state.frameCount = this->frameCount;
+    state.frameInstruction = this->frameInstruction;
+}
+
+void Chip8::loadState(const State& state)
+{
+    // The watchpoint filter belongs to the debugger, not the machine state
+    const uint64_t watchedReadPages = this->memory.watchedReadPages;
+    const uint64_t watchedWritePages = this->memory.watchedWritePages;
+
+    this->cpu = state.cpu;
+    this->memory = state.memory;
+    this->memory.watchpoints = &this->watchpoints;
+    this->memory.watchedReadPages = watchedReadPages;
+    this->memory.watchedWritePages = watchedWritePages;
+    this->display = state.display;
+    this->keypad = state.keypad;
+    this->instructionCount = state.instructionCount;
+    this->frameCount = state.frameCount;
+    this->frameInstruction = state.frameInstruction;
+
+    this->waitingForKey = false; // Set again by the next FX0A
+
+    // Savestates are taken between frames, the next beginFrame brings its own input
+    this->keyEventCount = 0;
+    this->nextKeyEvent = 0;
+}
+
+bool Chip8::runAhead(uint16_t keys, Display& display)
+{
+    TRACE_ZONE("Chip8::runAhead");
+
+    // Only between whole frames of a running machine, and never where the speculative frames would be observed
+    if(this->runAheadFrames == 0 || this->paused || !this->memory.romLoaded || this->frameInstruction != 0)
+        return false;
+
+    if(this->recorder.isRecording() || this->breakpoints.isActive() || this->watchpoints.isActive())
+        return false;
+
+    this->saveState(*this->runAheadState);
+
+    History* history = this->history;
+    const uint64_t skippedInstructions = this->skippedInstructions;
+    const uint64_t drawCount = this->drawCount;
+    const uint64_t drawBatchCount = this->drawBatchCount;
+    const uint64_t lastDrawInstruction = this->lastDrawInstruction;
+    const bool waitingForKey = this->waitingForKey;
+
+    this->history = nullptr;
+
+    for(uint8_t i = 0; i < this->runAheadFrames; ++i)
+        this->emulateCycle(keys);
+
+    display = this->display;
+
+    this->loadState(*this->runAheadState);
+
+    this->history = history;
+    this->skippedInstructions = skippedInstructions;
+    this->drawCount = drawCount;
+    this->drawBatchCount = drawBatchCount;
+    this->lastDrawInstruction = lastDrawInstruction;
+    this->waitingForKey = waitingForKey;
+
+    return true;
+}
+
+void Chip8::endFrame()
+{
+    ++this->frameCount;
+
+    this->frameInstruction = 0;
+
+    // Changes timed past the frame's budget still land, at its end
+    if(this->nextKeyEvent < this->keyEventCount)
+        this->keypad.updateMask(this->keyEvents[this->keyEventCount - 1].keys);
+
+    this->keyEventCount = 0;
+    this->nextKeyEvent = 0;
+
     if(this->cpu.delayTimer > 0)
         --this->cpu.delayTimer;
 
     if(this->cpu.soundTimer > 0)
         --this->cpu.soundTimer;
+
+    this->memory.decayAccesses();
+}
+
+void Chip8::executeRecorded(Instruction& instruction, uint16_t pc)
+{
+    const auto registers = this->cpu.v;
+    const uint16_t index = this->cpu.i;
+
+    this->execute(instruction);
+
+    Recorder::Record record {};
+
+    record.pc = pc;
+    record.word = instruction.word;
+    record.i = this->cpu.i;
+    record.opcode = instruction.opcode;
+    record.reg = Recorder::noRegister;
+    record.vf = this->cpu.v[0xF];
+    record.frame = static_cast<uint32_t>(this->frameCount);
+
+    for(uint8_t reg = 0; reg < 0xF; ++reg)
+    {
+        if(this->cpu.v[reg] == registers[reg])
+            continue;
+
+        if(record.reg != Recorder::noRegister)
+        {
+            record.flags |= Recorder::flagMultipleRegisters;
+            continue;
+        }
+
+        record.reg = reg;
+        record.value = this->cpu.v[reg];
+    }
+
+    if(this->cpu.v[0xF] != registers[0xF])
+        record.flags |= Recorder::flagVFChanged;
+
+    if(this->cpu.i != index)
+        record.flags |= Recorder::flagIChanged;
+
+    if(instruction.opcode == Opcode::OFX0A && !this->waitingForKey)
+        record.flags |= Recorder::flagKeyLoaded;
+
+    this->recorder.record(record);
 }
 
 void Chip8::execute(Instruction& instruction)
@@ -158,6 +578,13 @@ void Chip8::execute(Instruction& instruction)
 
         case Opcode::ODXYN:
             Instructions::DRW(this->display, this->memory, this->cpu, instruction.getX(), instruction.getY(), instruction.getN());
+
+            if(this->drawCount == 0 || this->instructionCount - this->lastDrawInstruction >= Chip8::drawBatchGap)
+                ++this->drawBatchCount;
+
+            ++this->drawCount;
+
+            this->lastDrawInstruction = this->instructionCount;
             break;
 
         case Opcode::OEX9E:
@@ -173,7 +600,7 @@ void Chip8::execute(Instruction& instruction)
             break;
 
         case Opcode::OFX0A:
-            Instructions::LD_VX_K(this->keypad, this->cpu, instruction.getX());
+            this->waitingForKey = !Instructions::LD_VX_K(this->keypad, this->cpu, instruction.getX());
             break;
 
         case Opcode::OFX15:
@@ -205,7 +632,9 @@ void Chip8::execute(Instruction& instruction)
             break;
 
         case Opcode::Invalid:
-            std::cerr << "Error: Invalid Opcode" << std::endl;
+            Logger::log(Logger::Level::Error, "Invalid opcode {x} at {x}", instruction.word, this->cpu.pc - 2);
+
+            Logger::flush();
 
             std::exit(EXIT_FAILURE);
             break;
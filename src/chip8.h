@@ -18,31 +18,154 @@
 
 #include <stdint.h>
 #include <iostream>
+#include <memory>
 
+#include "breakpoints.h"
 #include "instructions.h"
 #include "parser.h"
+#include "recorder.h"
+#include "watchpoints.h"
+
+class History;
 
 class Chip8
 {
+    public:
+        static constexpr const char* executionCore = "switch"; // Dispatch strategy used by execute
+
+        static constexpr uint8_t maxRunAheadFrames = 4;
+
+        static constexpr uint8_t drawBatchGap = 16;
+
+        static constexpr uint8_t maxKeyEvents = 8; // Key changes applied within one frame, later ones are merged into the last
+
+        struct KeyEvent
+        {
+            uint8_t instruction; // Index within the frame of the first instruction to see the keys
+
+            uint16_t keys; // The whole keypad mask from then on
+        };
+
     public:
         uint8_t instructionsPerSecond;
 
+        uint64_t instructionCount; // Instructions executed since construction
+
+        uint64_t frameCount; // Frames emulated since construction
+
+        uint8_t frameInstruction; // Instructions already executed in the current frame
+
+        bool skipIdleLoops; // Fast-forward loops that can't change anything until the next frame
+
+        uint64_t skippedInstructions; // Counted in instructionCount but never executed
+
+        uint8_t runAheadFrames; // Frames emulated past the real one for display only, 0 disables run-ahead
+
+        uint64_t drawCount; // DXYN instructions executed
+
+        uint64_t drawBatchCount; // Runs of DXYN with fewer than drawBatchGap instructions between them, roughly one per redraw
+
     public:
         CPU cpu;
         Memory memory;
         Display display;
         Keypad keypad;
 
+        Recorder recorder;
+
+        History* history; // Notified at the start of every frame when set
+
+        Breakpoints breakpoints;
+
+        Watchpoints watchpoints;
+
     public:
         bool paused;
 
+        bool waitingForKey; // The last instruction was an FX0A that found no key release
+
+    private:
+        // Idle loop detection, see runFrameSkippingIdle
+        uint16_t idleLoopTarget;
+        uint8_t idleLoopStart; // frameInstruction when the target was last reached
+        bool idleLoopClean; // No memory, display or key wait instruction since then
+        CPU idleLoopCPU;
+
+    private:
+        uint64_t lastDrawInstruction;
+
+    private:
+        std::array<KeyEvent, Chip8::maxKeyEvents> keyEvents; // The current frame's input, in order
+        uint8_t keyEventCount;
+        uint8_t nextKeyEvent;
+
+    private:
+        uint64_t resumeInstruction; // Breakpoints aren't checked here so continuing leaves the current one
+
+    public:
+        struct State
+        {
+            CPU cpu;
+            Memory memory;
+            Display display;
+            Keypad keypad;
+
+            uint64_t instructionCount;
+            uint64_t frameCount;
+
+            uint8_t frameInstruction;
+        };
+
+    private:
+        // Savestate buffers allocated once, too big for the stack and kept off function statics so each machine has its own
+        std::unique_ptr<State> recorderState; // Periodic states written to the trace
+        std::unique_ptr<State> runAheadState; // The real frame while run-ahead speculates
+
     private:
         void execute(Instruction& instruction);
 
+        void executeRecorded(Instruction& instruction, uint16_t pc);
+
+        bool runFrameChecked(); // Frame loop that stops at breakpoints and watchpoints, false when it stopped
+
+        void runFrameSkippingIdle();
+
+        void parkFrame(); // Accounts the budget up to the next key event to a pending FX0A without running it
+
+        void applyKeyEvents();
+
+        uint8_t getInputBoundary(); // frameInstruction at which the keys next change, or the frame's end
+
     public:
         Chip8();
 
         void reset(bool resetMemory);
 
-        void emulateCycle(const Uint8* keys);
+        void emulateCycle(uint16_t keys, const KeyEvent* events = nullptr, uint8_t eventCount = 0); // keys is the mask at the start of the frame
+
+        void replayFrame(uint16_t keys, uint8_t instructions, const KeyEvent* events = nullptr, uint8_t eventCount = 0); // Emulates a frame with recorded input and speed, ignoring paused
+
+        void beginFrame(uint16_t keys, const KeyEvent* events = nullptr, uint8_t eventCount = 0); // Latches the keypad and queues the frame's key changes
+
+        void step(); // Executes a single instruction
+
+        bool isBlocked(); // Nothing changes until a key is released, so the host may sleep on input
+
+        void advance(); // Executes a single instruction, beginning and ending frames as the speed requires
+
+        void endFrame(); // Ticks the timers
+
+        void resume(); // Unpauses without stopping again at the current breakpoint
+
+        void stepOver(); // Runs a CALL until it returns, single-steps anything else
+
+        void stepOut(); // Runs until the current subroutine returns
+
+        void runTo(uint16_t address);
+
+        void saveState(State& state);
+
+        void loadState(const State& state);
+
+        bool runAhead(uint16_t keys, Display& display); // Renders runAheadFrames into display and rolls back, false when it can't
 };
@@ -0,0 +1,529 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "condition.h"
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+bool Condition::compile(const std::string& source)
+{
+    this->source = source;
+    this->error.clear();
+    this->code.clear();
+
+    this->cursor = this->source.c_str();
+    this->depth = 0;
+    this->maxDepth = 0;
+
+    if(!this->parseOr())
+    {
+        this->code.clear();
+        return false;
+    }
+
+    this->skipSpace();
+
+    if(*this->cursor != '\0')
+    {
+        this->code.clear();
+        return this->fail("Unexpected text");
+    }
+
+    if(this->maxDepth > Condition::stackSize)
+    {
+        this->code.clear();
+        return this->fail("Expression too deep");
+    }
+
+    return true;
+}
+
+bool Condition::isValid() const
+{
+    return !this->code.empty();
+}
+
+bool Condition::fail(const char* message)
+{
+    // Keep the first error, it points closest to the real problem
+    if(this->error.empty())
+        this->error = std::string(message) + " at column " + std::to_string(this->cursor - this->source.c_str() + 1);
+
+    return false;
+}
+
+void Condition::skipSpace()
+{
+    while(std::isspace(static_cast<unsigned char>(*this->cursor)))
+        ++this->cursor;
+}
+
+bool Condition::accept(const char* token)
+{
+    this->skipSpace();
+
+    const size_t length = std::strlen(token);
+
+    if(std::strncmp(this->cursor, token, length) != 0)
+        return false;
+
+    this->cursor += length;
+
+    return true;
+}
+
+bool Condition::acceptWord(const char* word)
+{
+    this->skipSpace();
+
+    const size_t length = std::strlen(word);
+
+    for(size_t i = 0; i < length; ++i)
+    {
+        if(std::toupper(static_cast<unsigned char>(this->cursor[i])) != word[i])
+            return false;
+    }
+
+    if(std::isalnum(static_cast<unsigned char>(this->cursor[length])))
+        return false;
+
+    this->cursor += length;
+
+    return true;
+}
+
+void Condition::emit(Code code, uint16_t value)
+{
+    this->code.push_back({code, value});
+
+    switch(code)
+    {
+        case Code::Push:
+        case Code::Register:
+        case Code::Index:
+        case Code::ProgramCounter:
+        case Code::StackPointer:
+        case Code::DelayTimer:
+        case Code::SoundTimer:
+            ++this->depth;
+            break;
+
+        case Code::Load:
+        case Code::LogicalNot:
+        case Code::BitNot:
+        case Code::Negate:
+            break;
+
+        default:
+            --this->depth;
+            break;
+    }
+
+    if(this->depth > this->maxDepth)
+        this->maxDepth = this->depth;
+}
+
+bool Condition::parseOr()
+{
+    if(!this->parseAnd())
+        return false;
+
+    while(this->accept("||"))
+    {
+        if(!this->parseAnd())
+            return false;
+
+        this->emit(Code::LogicalOr);
+    }
+
+    return true;
+}
+
+bool Condition::parseAnd()
+{
+    if(!this->parseBitOr())
+        return false;
+
+    while(this->accept("&&"))
+    {
+        if(!this->parseBitOr())
+            return false;
+
+        this->emit(Code::LogicalAnd);
+    }
+
+    return true;
+}
+
+bool Condition::parseBitOr()
+{
+    if(!this->parseBitXor())
+        return false;
+
+    for(;;)
+    {
+        this->skipSpace();
+
+        if(this->cursor[0] != '|' || this->cursor[1] == '|')
+            return true;
+
+        ++this->cursor;
+
+        if(!this->parseBitXor())
+            return false;
+
+        this->emit(Code::BitOr);
+    }
+}
+
+bool Condition::parseBitXor()
+{
+    if(!this->parseBitAnd())
+        return false;
+
+    while(this->accept("^"))
+    {
+        if(!this->parseBitAnd())
+            return false;
+
+        this->emit(Code::BitXor);
+    }
+
+    return true;
+}
+
+bool Condition::parseBitAnd()
+{
+    if(!this->parseEquality())
+        return false;
+
+    for(;;)
+    {
+        this->skipSpace();
+
+        if(this->cursor[0] != '&' || this->cursor[1] == '&')
+            return true;
+
+        ++this->cursor;
+
+        if(!this->parseEquality())
+            return false;
+
+        this->emit(Code::BitAnd);
+    }
+}
+
+bool Condition::parseEquality()
+{
+    if(!this->parseRelational())
+        return false;
+
+    for(;;)
+    {
+        Code code;
+
+        if(this->accept("=="))
+            code = Code::Equal;
+        else if(this->accept("!="))
+            code = Code::NotEqual;
+        else
+            return true;
+
+        if(!this->parseRelational())
+            return false;
+
+        this->emit(code);
+    }
+}
+
+bool Condition::parseRelational()
+{
+    if(!this->parseAdditive())
+        return false;
+
+    for(;;)
+    {
+        Code code;
+
+        // Two-character operators first so "<=" isn't read as "<"
+        if(this->accept("<="))
+            code = Code::LessEqual;
+        else if(this->accept(">="))
+            code = Code::GreaterEqual;
+        else if(this->accept("<"))
+            code = Code::Less;
+        else if(this->accept(">"))
+            code = Code::Greater;
+        else
+            return true;
+
+        if(!this->parseAdditive())
+            return false;
+
+        this->emit(code);
+    }
+}
+
+bool Condition::parseAdditive()
+{
+    if(!this->parseUnary())
+        return false;
+
+    for(;;)
+    {
+        Code code;
+
+        if(this->accept("+"))
+            code = Code::Add;
+        else if(this->accept("-"))
+            code = Code::Subtract;
+        else
+            return true;
+
+        if(!this->parseUnary())
+            return false;
+
+        this->emit(code);
+    }
+}
+
+bool Condition::parseUnary()
+{
+    this->skipSpace();
+
+    Code code;
+
+    if(this->cursor[0] == '!' && this->cursor[1] != '=')
+        code = Code::LogicalNot;
+    else if(this->cursor[0] == '~')
+        code = Code::BitNot;
+    else if(this->cursor[0] == '-')
+        code = Code::Negate;
+    else
+        return this->parsePrimary();
+
+    ++this->cursor;
+
+    if(!this->parseUnary())
+        return false;
+
+    this->emit(code);
+
+    return true;
+}
+
+bool Condition::parsePrimary()
+{
+    this->skipSpace();
+
+    if(this->accept("("))
+    {
+        if(!this->parseOr())
+            return false;
+
+        if(!this->accept(")"))
+            return this->fail("Expected ')'");
+
+        return true;
+    }
+
+    if(this->accept("["))
+    {
+        if(!this->parseOr())
+            return false;
+
+        if(!this->accept("]"))
+            return this->fail("Expected ']'");
+
+        this->emit(Code::Load);
+
+        return true;
+    }
+
+    if(std::isdigit(static_cast<unsigned char>(*this->cursor)))
+    {
+        // Hex only with 0x, a leading zero is still decimal rather than octal
+        const bool hex = this->cursor[0] == '0' && (this->cursor[1] == 'x' || this->cursor[1] == 'X');
+
+        if(hex && !std::isxdigit(static_cast<unsigned char>(this->cursor[2])))
+            return this->fail("Expected hex digits after 0x");
+
+        char* end;
+
+        const unsigned long value = std::strtoul(this->cursor, &end, hex ? 16 : 10);
+
+        if(value > 0xFFFF)
+            return this->fail("Number out of range");
+
+        this->cursor = end;
+
+        this->emit(Code::Push, static_cast<uint16_t>(value));
+
+        return true;
+    }
+
+    if((this->cursor[0] == 'V' || this->cursor[0] == 'v') && std::isxdigit(static_cast<unsigned char>(this->cursor[1])) && !std::isalnum(static_cast<unsigned char>(this->cursor[2])))
+    {
+        const char digit = std::toupper(static_cast<unsigned char>(this->cursor[1]));
+
+        this->cursor += 2;
+
+        this->emit(Code::Register, digit <= '9' ? digit - '0' : digit - 'A' + 10);
+
+        return true;
+    }
+
+    if(this->acceptWord("PC"))
+        this->emit(Code::ProgramCounter);
+    else if(this->acceptWord("SP"))
+        this->emit(Code::StackPointer);
+    else if(this->acceptWord("DT"))
+        this->emit(Code::DelayTimer);
+    else if(this->acceptWord("ST"))
+        this->emit(Code::SoundTimer);
+    else if(this->acceptWord("I"))
+        this->emit(Code::Index);
+    else
+        return this->fail("Expected a value");
+
+    return true;
+}
+
+bool Condition::evaluate(const CPU& cpu, Memory& memory) const
+{
+    int32_t stack[Condition::stackSize];
+    uint8_t top = 0;
+
+    for(const Op& op : this->code)
+    {
+        switch(op.code)
+        {
+            case Code::Push:
+                stack[top++] = op.value;
+                break;
+
+            case Code::Register:
+                stack[top++] = cpu.v[op.value];
+                break;
+
+            case Code::Index:
+                stack[top++] = cpu.i;
+                break;
+
+            case Code::ProgramCounter:
+                stack[top++] = cpu.pc;
+                break;
+
+            case Code::StackPointer:
+                stack[top++] = cpu.sp;
+                break;
+
+            case Code::DelayTimer:
+                stack[top++] = cpu.delayTimer;
+                break;
+
+            case Code::SoundTimer:
+                stack[top++] = cpu.soundTimer;
+                break;
+
+            case Code::Load:
+                stack[top - 1] = memory[stack[top - 1] & (Memory::memorySize - 1)];
+                break;
+
+            case Code::LogicalNot:
+                stack[top - 1] = !stack[top - 1];
+                break;
+
+            case Code::BitNot:
+                stack[top - 1] = ~stack[top - 1];
+                break;
+
+            case Code::Negate:
+                stack[top - 1] = -stack[top - 1];
+                break;
+
+            default:
+            {
+                const int32_t right = stack[--top];
+                int32_t& left = stack[top - 1];
+
+                switch(op.code)
+                {
+                    case Code::Add:
+                        left = left + right;
+                        break;
+
+                    case Code::Subtract:
+                        left = left - right;
+                        break;
+
+                    case Code::BitAnd:
+                        left = left & right;
+                        break;
+
+                    case Code::BitOr:
+                        left = left | right;
+                        break;
+
+                    case Code::BitXor:
+                        left = left ^ right;
+                        break;
+
+                    case Code::Equal:
+                        left = left == right;
+                        break;
+
+                    case Code::NotEqual:
+                        left = left != right;
+                        break;
+
+                    case Code::Less:
+                        left = left < right;
+                        break;
+
+                    case Code::LessEqual:
+                        left = left <= right;
+                        break;
+
+                    case Code::Greater:
+                        left = left > right;
+                        break;
+
+                    case Code::GreaterEqual:
+                        left = left >= right;
+                        break;
+
+                    case Code::LogicalAnd:
+                        left = left && right;
+                        break;
+
+                    case Code::LogicalOr:
+                        left = left || right;
+                        break;
+
+                    default:
+                        break;
+                }
+
+                break;
+            }
+        }
+    }
+
+    // An empty program is an unconditional breakpoint
+    return top == 0 || stack[top - 1] != 0;
+}
@@ -0,0 +1,107 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "memory.h"
+
+// A breakpoint condition such as "V3 == 0x10 && I > 0x300 && DT == 0", compiled once into stack
+// bytecode so evaluating it on every hit doesn't touch the source text.
+//
+// Operands: numbers (decimal or 0x hex), V0 to VF, I, PC, SP, DT, ST and [expr] for a memory byte.
+// Operators in C precedence: unary ! ~ -, + -, < <= > >=, == !=, &, ^, |, &&, ||.
+
+class Condition
+{
+    public:
+        static constexpr uint8_t stackSize = 16;
+
+    private:
+        enum class Code : uint8_t
+        {
+            Push,
+            Register,
+            Index,
+            ProgramCounter,
+            StackPointer,
+            DelayTimer,
+            SoundTimer,
+            Load,
+            Add,
+            Subtract,
+            BitAnd,
+            BitOr,
+            BitXor,
+            Equal,
+            NotEqual,
+            Less,
+            LessEqual,
+            Greater,
+            GreaterEqual,
+            LogicalAnd,
+            LogicalOr,
+            LogicalNot,
+            BitNot,
+            Negate,
+        };
+
+        struct Op
+        {
+            Code code;
+            uint16_t value; // Immediate for Push, register number for Register
+        };
+
+        std::vector<Op> code;
+
+        const char* cursor; // Only valid while compiling
+        uint8_t depth;
+        uint8_t maxDepth;
+
+    public:
+        std::string source;
+        std::string error; // Empty when the source compiled
+
+    private:
+        void skipSpace();
+        bool accept(const char* token);
+        bool acceptWord(const char* word); // Like accept, but not when followed by more identifier characters
+
+        void emit(Code code, uint16_t value = 0);
+
+        bool parseOr();
+        bool parseAnd();
+        bool parseBitOr();
+        bool parseBitXor();
+        bool parseBitAnd();
+        bool parseEquality();
+        bool parseRelational();
+        bool parseAdditive();
+        bool parseUnary();
+        bool parsePrimary();
+
+        bool fail(const char* message);
+
+    public:
+        bool compile(const std::string& source);
+
+        bool isValid() const;
+
+        bool evaluate(const CPU& cpu, Memory& memory) const;
+};
@@ -15,6 +15,7 @@
 //     along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "cpu.h"
+#include <cstdlib>
 
 CPU::CPU()
 {
@@ -34,4 +35,6 @@ void CPU::reset()
     
     for(auto& layer : this->stack)
         layer = 0;
+
+    this->rngState = rand() | 1; // Xorshift never leaves zero
 }
@@ -42,6 +42,8 @@ class CPU
         std::array<uint8_t, CPU::registerCount> v; // Registers 0 to F
 
         std::array<uint16_t, CPU::stackSize> stack; // Stores return addresses
+
+        uint32_t rngState; // Xorshift state for RND, kept here so savestates replay the same numbers
     
     public:
         CPU();
@@ -15,174 +15,171 @@
 //     along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "disassembler.h"
-#include <sstream>
-#include <iostream>
+#include "trace.h"
 
-template<typename T>
-std::string to_hexadecimal(T t)
+namespace
 {
-    std::stringstream stream;
+    constexpr char hexDigits[] = "0123456789ABCDEF";
 
-    stream << std::setfill('0') << std::uppercase << std::hex << t;
+    // Minimal-width uppercase hex, matching what the disassembly has always printed
+    char* writeHex(char* out, char* end, uint16_t value)
+    {
+        int shift = 12;
+
+        while(shift > 0 && ((value >> shift) & 0xF) == 0)
+            shift -= 4;
+
+        for(; shift >= 0 && out < end; shift -= 4)
+            *out++ = hexDigits[(value >> shift) & 0xF];
+
+        return out;
+    }
+
+    char* writeString(char* out, char* end, const char* string)
+    {
+        while(*string != '\0' && out < end)
+            *out++ = *string++;
 
-    return stream.str();
+        return out;
+    }
 }
 
-std::vector<std::string> Disassembler::disassemble(Memory& memory)
+size_t Disassembler::disassembleInstruction(char* buffer, size_t size, uint16_t address, Instruction instruction)
 {
-    uint16_t pc = CPU::pcStart;
+    if(size == 0)
+        return 0;
 
-    for(uint16_t i = 0; i < memory.romSize; i += 2)
-    {
-        Instruction instruction(memory.fetchWord(pc));
+    char* out = buffer;
+    char* const end = buffer + size - 1; // Room for the terminator
 
-        pc += 2;
+    const Format& format = Disassembler::formats[static_cast<size_t>(instruction.opcode)];
 
-        instruction.opcode = Parser::parse(instruction);
+    out = writeHex(out, end, address);
 
-        switch(instruction.opcode)
-        {
-            case Opcode::O00E0:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::CLS)]);
-                break;
+    // Data words have never had the colon, keep lines diffable against older output
+    out = writeString(out, end, instruction.opcode == Opcode::Invalid ? " " : ": ");
+    out = writeString(out, end, format.mnemonic);
 
-            case Opcode::O00EE:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::RET)]);
-                break;
+    if(format.operands[0] != '\0')
+        out = writeString(out, end, " ");
 
-            case Opcode::O1NNN:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::JMP)] + " " + to_hexadecimal(instruction.getNNN()));
+    for(const char* field = format.operands; *field != '\0' && out < end; ++field)
+    {
+        switch(*field)
+        {
+            case 'x':
+                *out++ = hexDigits[instruction.getX()];
                 break;
 
-            case Opcode::O2NNN:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::JMP)] + " " + to_hexadecimal(instruction.getNNN()));
+            case 'y':
+                *out++ = hexDigits[instruction.getY()];
                 break;
 
-            case Opcode::O3XNN:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::SE)] + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())) + " " + to_hexadecimal(static_cast<size_t>(instruction.getNN())));
+            case 'n':
+                *out++ = hexDigits[instruction.getN()];
                 break;
 
-            case Opcode::O4XNN:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::SNE)] + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())) + " " + to_hexadecimal(static_cast<size_t>(instruction.getNN())));
+            case 'b':
+                out = writeHex(out, end, instruction.getNN());
                 break;
 
-            case Opcode::O5XY0:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::SE)] + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())) + " V" + to_hexadecimal(static_cast<size_t>(instruction.getY())));
+            case 'a':
+                out = writeHex(out, end, instruction.getNNN());
                 break;
 
-            case Opcode::O6XNN:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::LD)] + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())) + " " + to_hexadecimal(static_cast<size_t>(instruction.getNN())));
+            case 'w':
+                out = writeHex(out, end, instruction.word);
                 break;
 
-            case Opcode::O7XNN:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::ADD)] + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())) + " " + to_hexadecimal(static_cast<size_t>(instruction.getNN())));
+            default:
+                *out++ = *field;
                 break;
+        }
+    }
 
-            case Opcode::O8XY0:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::LD)] + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())) + " V" + to_hexadecimal(static_cast<size_t>(instruction.getY())));
-                break;
+    *out = '\0';
 
-            case Opcode::O8XY1:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::OR)] + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())) + " V" + to_hexadecimal(static_cast<size_t>(instruction.getY())));
-                break;
+    return out - buffer;
+}
 
-            case Opcode::O8XY2:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::AND)] + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())) + " V" + to_hexadecimal(static_cast<size_t>(instruction.getY())));
-                break;
+size_t Disassembler::disassembleData(char* buffer, size_t size, uint16_t address, const uint8_t* bytes, size_t count)
+{
+    if(size == 0)
+        return 0;
 
-            case Opcode::O8XY3:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::XOR)] + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())) + " V" + to_hexadecimal(static_cast<size_t>(instruction.getY())));
-                break;
+    char* out = buffer;
+    char* const end = buffer + size - 1; // Room for the terminator
 
-            case Opcode::O8XY4:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::ADD)] + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())) + " V" + to_hexadecimal(static_cast<size_t>(instruction.getY())));
-                break;
+    out = writeHex(out, end, address);
+    out = writeString(out, end, " DATA");
 
-            case Opcode::O8XY5:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::SUB)] + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())) + " V" + to_hexadecimal(static_cast<size_t>(instruction.getY())));
-                break;
+    for(size_t i = 0; i < count && end - out >= 3; ++i)
+    {
+        *out++ = ' ';
+        *out++ = hexDigits[bytes[i] >> 4];
+        *out++ = hexDigits[bytes[i] & 0xF];
+    }
 
-            case Opcode::O8XY6:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::SHR)] + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())) + " V" + to_hexadecimal(static_cast<size_t>(instruction.getY())));
-                break;
+    *out = '\0';
 
-            case Opcode::O8XY7:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::SUBN)] + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())) + " V" + to_hexadecimal(static_cast<size_t>(instruction.getY())));
-                break;
+    return out - buffer;
+}
 
-            case Opcode::O8XYE:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::SHL)] + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())) + " V" + to_hexadecimal(static_cast<size_t>(instruction.getY())));
-                break;
+size_t Disassembler::disassembleRange(char* buffer, size_t size, Memory& memory, uint16_t start, uint16_t end, uint16_t* next)
+{
+    size_t written = 0;
 
-            case Opcode::O9XY0:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::SNE)] + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())) + " V" + to_hexadecimal(static_cast<size_t>(instruction.getY())));
-                break;
+    uint16_t address = start;
 
-            case Opcode::OANNN:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::LD)] + " " + to_hexadecimal(instruction.getNNN()));
-                break;
+    for(; address < end; address += 2)
+    {
+        // A line plus its newline must fit, along with the final terminator
+        if(size - written < Disassembler::maxLineLength + 1)
+            break;
 
-            case Opcode::OBNNN:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::JMP)] + " V0 " + to_hexadecimal(instruction.getNNN()));
-                break;
+        Instruction instruction(memory.peekWord(address));
 
-            case Opcode::OCXNN:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::RND)] + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())) + " " + to_hexadecimal(static_cast<size_t>(instruction.getNN())));
-                break;
+        instruction.opcode = Parser::parse(instruction);
 
-            case Opcode::ODXYN:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::DRW)] + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())) + " V" + to_hexadecimal(static_cast<size_t>(instruction.getY())) + " " + to_hexadecimal(static_cast<size_t>(static_cast<size_t>(instruction.getN()))));
-                break;
+        written += Disassembler::disassembleInstruction(buffer + written, size - written, address, instruction);
 
-            case Opcode::OEX9E:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::SKP)] + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())));
-                break;
+        buffer[written++] = '\n';
+    }
 
-            case Opcode::OEXA1:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::SKNP)] + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())));
-                break;
+    if(size > 0)
+        buffer[written < size ? written : size - 1] = '\0';
 
-            case Opcode::OFX07:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::LD)] + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())) + " DT");
-                break;
+    if(next != nullptr)
+        *next = address;
 
-            case Opcode::OFX0A:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::LD)] + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())) + " K");
-                break;
+    return written;
+}
 
-            case Opcode::OFX15:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::LD)] + " DT" + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())));
-                break;
+std::string Disassembler::disassembleInstruction(uint16_t address, Instruction instruction)
+{
+    char line[Disassembler::maxLineLength];
 
-            case Opcode::OFX18:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::LD)] + " ST" + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())));
-                break;
+    const size_t length = Disassembler::disassembleInstruction(line, sizeof(line), address, instruction);
 
-            case Opcode::OFX1E:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::ADD)] + " I" + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())));
-                break;
+    return std::string(line, length);
+}
 
-            case Opcode::OFX29:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::LD)] + " F" + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())));
-                break;
+std::vector<std::string> Disassembler::disassemble(Memory& memory)
+{
+    TRACE_ZONE("Disassembler::disassemble");
 
-            case Opcode::OFX33:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::LD)] + " B" + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())));
-                break;
+    std::vector<std::string> instructions;
 
-            case Opcode::OFX55:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::LD)] + " MI" + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())));
-                break;
+    instructions.reserve((memory.romSize + 1) / 2);
 
-            case Opcode::OFX65:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + ": " + this->instructionStrings[static_cast<uint8_t>(Instructions::LD)] + " V" + to_hexadecimal(static_cast<size_t>(instruction.getX())) + " MI");
-                break;
+    for(uint16_t pc = CPU::pcStart; pc < CPU::pcStart + memory.romSize; pc += 2)
+    {
+        Instruction instruction(memory.peekWord(pc));
 
-            case Opcode::Invalid:
-                this->disassembledInstructions.push_back(to_hexadecimal(pc - 2) + " " + "DATA " + to_hexadecimal(instruction.word));
-                break;
-        }
+        instruction.opcode = Parser::parse(instruction);
+
+        instructions.push_back(this->disassembleInstruction(pc, instruction));
     }
 
-    return this->disassembledInstructions;
-}
\ No newline at end of file
+    return instructions;
+}
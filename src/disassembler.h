@@ -17,6 +17,8 @@
 #pragma once
 
 #include <stdint.h>
+#include <array>
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -24,55 +26,74 @@
 
 struct Disassembler
 {
-    private:
-        enum class Instructions : uint8_t
-        {
-            CLS,
-            RET,
-            JMP,
-            CALL,
-            SE,
-            SNE,
-            LD,
-            ADD,
-            OR,
-            AND,
-            XOR,
-            SUB,
-            SHR,
-            SUBN,
-            SHL,
-            RND,
-            DRW,
-            SKP,
-            SKNP,
-        };
+    public:
+        static constexpr size_t maxLineLength = 24; // Longest line including the terminator, "FFF: DRW VF VF F"
+
+        static constexpr size_t dataBytesPerLine = 8; // Bytes on one DATA line of an analysed listing
+
+        static constexpr size_t maxDataLineLength = 9 + Disassembler::dataBytesPerLine * 3; // "FFF DATA" and " FF" per byte, with the terminator
 
-        const std::array<std::string, 19> instructionStrings
+    private:
+        // Operand patterns copy characters through except for these lowercase fields:
+        // x, y and n are single nibbles, b is NN, a is NNN and w is the whole word, all in minimal hex
+        struct Format
         {
-            "CLS",
-            "RET",
-            "JMP",
-            "CALL",
-            "SE",
-            "SNE",
-            "LD",
-            "ADD",
-            "OR",
-            "AND",
-            "XOR",
-            "SUB",
-            "SHR",
-            "SUBN",
-            "SHL",
-            "RND",
-            "DRW",
-            "SKP",
-            "SKNP",
+            const char* mnemonic;
+            const char* operands;
         };
 
-        std::vector<std::string> disassembledInstructions;
+        static constexpr std::array<Format, static_cast<size_t>(Opcode::Invalid) + 1> formats
+        {{
+            {"CLS", ""},        // 00E0
+            {"RET", ""},        // 00EE
+            {"JMP", "a"},       // 1NNN
+            {"CALL", "a"},      // 2NNN
+            {"SE", "Vx b"},     // 3XNN
+            {"SNE", "Vx b"},    // 4XNN
+            {"SE", "Vx Vy"},    // 5XY0
+            {"LD", "Vx b"},     // 6XNN
+            {"ADD", "Vx b"},    // 7XNN
+            {"LD", "Vx Vy"},    // 8XY0
+            {"OR", "Vx Vy"},    // 8XY1
+            {"AND", "Vx Vy"},   // 8XY2
+            {"XOR", "Vx Vy"},   // 8XY3
+            {"ADD", "Vx Vy"},   // 8XY4
+            {"SUB", "Vx Vy"},   // 8XY5
+            {"SHR", "Vx Vy"},   // 8XY6
+            {"SUBN", "Vx Vy"},  // 8XY7
+            {"SHL", "Vx Vy"},   // 8XYE
+            {"SNE", "Vx Vy"},   // 9XY0
+            {"LD", "a"},        // ANNN
+            {"JMP", "V0 a"},    // BNNN
+            {"RND", "Vx b"},    // CXNN
+            {"DRW", "Vx Vy n"}, // DXYN
+            {"SKP", "Vx"},      // EX9E
+            {"SKNP", "Vx"},     // EXA1
+            {"LD", "Vx DT"},    // FX07
+            {"LD", "Vx K"},     // FX0A
+            {"LD", "DT Vx"},    // FX15
+            {"LD", "ST Vx"},    // FX18
+            {"ADD", "I Vx"},    // FX1E
+            {"LD", "F Vx"},     // FX29
+            {"LD", "B Vx"},     // FX33
+            {"LD", "MI Vx"},    // FX55
+            {"LD", "Vx MI"},    // FX65
+            {"DATA", "w"},      // Invalid
+        }};
 
     public:
+        // Writes one line into buffer, truncating to size, and returns its length without the terminator.
+        // Nothing is allocated, so this is safe to call per row per frame.
+        static size_t disassembleInstruction(char* buffer, size_t size, uint16_t address, Instruction instruction);
+
+        // As above for a run of bytes the analysis didn't reach, "FFF DATA 12 34", same layout as an undecodable word
+        static size_t disassembleData(char* buffer, size_t size, uint16_t address, const uint8_t* bytes, size_t count);
+
+        // Writes the lines for [start, end) separated by newlines, stopping before a line that doesn't fit.
+        // Returns the bytes written, and the address reached through next when given.
+        static size_t disassembleRange(char* buffer, size_t size, Memory& memory, uint16_t start, uint16_t end, uint16_t* next = nullptr);
+
+        std::string disassembleInstruction(uint16_t address, Instruction instruction);
+
         std::vector<std::string> disassemble(Memory& memory);
-};
\ No newline at end of file
+};
@@ -0,0 +1,169 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "disassemblycache.h"
+#include <cstring>
+
+DisassemblyCache::DisassemblyCache() : rowCount(0), layoutHash(0), layoutAnalysed(false), layoutEnd(0), misses(0)
+{
+    this->rowOf.fill(DisassemblyCache::noRow);
+
+    for(Line& line : this->lines)
+    {
+        line.size = 0;
+        line.code = false;
+    }
+
+    this->invalidate();
+}
+
+void DisassemblyCache::addRow(uint16_t address, uint8_t size, bool code)
+{
+    Line& line = this->lines[address];
+
+    // A row that changed shape since its text was made is redone
+    if(line.size != size || line.code != code)
+        line.valid = false;
+
+    line.size = size;
+    line.code = code;
+
+    for(uint16_t covered = address; covered < address + size && covered < Memory::memorySize; ++covered)
+        this->rowOf[covered] = this->rowCount;
+
+    this->rows[this->rowCount++] = address;
+}
+
+void DisassemblyCache::layout(const Analysis* analysis, uint16_t end, uint16_t pc)
+{
+    const uint64_t hash = analysis != nullptr ? analysis->romHash : 0;
+
+    if(hash != this->layoutHash || (analysis != nullptr) != this->layoutAnalysed || end != this->layoutEnd)
+    {
+        this->layoutHash = hash;
+        this->layoutAnalysed = analysis != nullptr;
+        this->layoutEnd = end;
+
+        this->build(analysis, end, DisassemblyCache::noPC);
+    }
+
+    // A running ROM's PC is almost always at a row start already, only an odd or unreached one moves rows
+    const uint16_t row = this->getLine(pc);
+
+    if(row != DisassemblyCache::noRow && this->rows[row] != pc)
+        this->build(analysis, end, pc);
+}
+
+void DisassemblyCache::build(const Analysis* analysis, uint16_t end, uint32_t pc)
+{
+    this->rowOf.fill(DisassemblyCache::noRow);
+    this->rowCount = 0;
+
+    // Code starts, a row never runs over the PC
+    const auto startsInstruction = [analysis, end, pc](uint32_t address)
+    {
+        return address == pc || ((analysis == nullptr || analysis->isCode(address)) && address + 1 < end && address + 1 != pc);
+    };
+
+    for(uint32_t address = CPU::pcStart; address < end;)
+    {
+        if(startsInstruction(address))
+        {
+            this->addRow(address, 2, true);
+
+            address += 2;
+            continue;
+        }
+
+        // Same grouping as chip8-disasm -a, up to a line of bytes that stops at the next instruction
+        uint8_t size = 1;
+
+        while(size < Disassembler::dataBytesPerLine && address + size < end && !startsInstruction(address + size))
+            ++size;
+
+        this->addRow(address, size, false);
+
+        address += size;
+    }
+}
+
+uint16_t DisassemblyCache::getRowCount() const
+{
+    return this->rowCount;
+}
+
+uint16_t DisassemblyCache::getAddress(uint16_t row) const
+{
+    return this->rows[row];
+}
+
+uint16_t DisassemblyCache::getLine(uint16_t address) const
+{
+    return this->rowOf[address & (Memory::memorySize - 1)];
+}
+
+bool DisassemblyCache::isCode(uint16_t address) const
+{
+    return this->lines[address].code;
+}
+
+const char* DisassemblyCache::get(Memory& memory, uint16_t address)
+{
+    Line& line = this->lines[address];
+
+    std::array<uint8_t, Disassembler::dataBytesPerLine> bytes {};
+
+    if(line.code)
+    {
+        const uint16_t word = memory.peekWord(address);
+
+        bytes[0] = word >> 8;
+        bytes[1] = word & 0xFF;
+    }
+    else
+    {
+        std::memcpy(bytes.data(), memory.getData() + address, line.size);
+    }
+
+    if(line.valid && line.bytes == bytes)
+        return line.text.data();
+
+    if(line.code)
+    {
+        Instruction instruction(bytes[0] << 8 | bytes[1]);
+
+        instruction.opcode = Parser::parse(instruction);
+
+        Disassembler::disassembleInstruction(line.text.data(), line.text.size(), address, instruction);
+    }
+    else
+    {
+        Disassembler::disassembleData(line.text.data(), line.text.size(), address, bytes.data(), line.size);
+    }
+
+    line.bytes = bytes;
+    line.valid = true;
+
+    ++this->misses;
+
+    return line.text.data();
+}
+
+void DisassemblyCache::invalidate()
+{
+    for(Line& line : this->lines)
+        line.valid = false;
+}
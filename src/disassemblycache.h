@@ -0,0 +1,93 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <stdint.h>
+#include <array>
+
+#include "analysis.h"
+#include "disassembler.h"
+
+// Disassembled rows for the program area, kept between GUI frames. Rows follow the control-flow analysis
+// like chip8-disasm -a: one instruction per reached code address and runs of DATA bytes everywhere else.
+// A row's text is redone only when the bytes under it differ from the ones it was made from, so
+// self-modifying code stays correct.
+
+class DisassemblyCache
+{
+    public:
+        static constexpr uint16_t maxRows = Memory::memorySize - CPU::pcStart;
+
+        static constexpr uint16_t noRow = UINT16_MAX;
+
+    private:
+        struct Line
+        {
+            std::array<char, Disassembler::maxDataLineLength> text;
+
+            std::array<uint8_t, Disassembler::dataBytesPerLine> bytes; // Memory the text was made from
+
+            uint8_t size; // Bytes the row covers
+
+            bool code; // An instruction rather than a run of data
+
+            bool valid;
+        };
+
+        std::array<Line, Memory::memorySize> lines; // Indexed by the row's start address
+
+        std::array<uint16_t, DisassemblyCache::maxRows> rows; // Start address of each row in order
+
+        std::array<uint16_t, Memory::memorySize> rowOf; // Row containing each address, noRow outside the layout
+
+        uint16_t rowCount;
+
+        // What the current layout was built from
+        uint64_t layoutHash;
+        bool layoutAnalysed;
+        uint16_t layoutEnd;
+
+    public:
+        uint64_t misses; // Rows disassembled since construction
+
+    private:
+        static constexpr uint32_t noPC = UINT32_MAX; // Lays out from the analysis alone
+
+        void addRow(uint16_t address, uint8_t size, bool code);
+
+        void build(const Analysis* analysis, uint16_t end, uint32_t pc); // Walks [pcStart, end), pc always starting an instruction row
+
+    public:
+        DisassemblyCache();
+
+        // Lays out [pcStart, end) when the analysis or the end changed. The PC always starts an instruction
+        // row so code the analysis didn't reach can still be followed, which only walks the program again
+        // when the PC isn't at a row start. Without an analysis every word is shown as an instruction.
+        void layout(const Analysis* analysis, uint16_t end, uint16_t pc);
+
+        uint16_t getRowCount() const;
+
+        uint16_t getAddress(uint16_t row) const;
+
+        uint16_t getLine(uint16_t address) const; // Row containing the address, noRow outside the layout
+
+        bool isCode(uint16_t address) const; // True when the row starting at address is an instruction
+
+        const char* get(Memory& memory, uint16_t address); // Text of the row starting at address
+
+        void invalidate();
+};
@@ -15,12 +15,30 @@
 //     along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "gui.h"
+#include <algorithm>
+#include <cstdio>
+
+#include "allocations.h"
+#include "logger.h"
 
 bool GUI::showSettings = false;
 bool GUI::isROMInputActive = false;
 
 bool GUI::showDebugWindows = false;
 
+bool GUI::showFrameTimes = false;
+
+FrameArena GUI::frameArena;
+
+DisassemblyCache GUI::disassemblyCache;
+
+std::shared_ptr<const Analysis> GUI::analysis;
+
+TraceIndex GUI::traceIndex;
+bool GUI::showTrace = false;
+
+bool GUI::showWatchpoints = false;
+
 void GUI::init(SDL_Window* window, SDL_Renderer* renderer)
 {
     IMGUI_CHECKVERSION();
@@ -46,7 +64,7 @@ void GUI::processEvent(SDL_Event event)
     ImGui_ImplSDL2_ProcessEvent(&event);
 }
 
-void GUI::drawSettings(Chip8& chip8, uint8_t& frameTime, bool& takeScreenshot)
+void GUI::drawSettings(Chip8& chip8, AutoSpeed& autoSpeed, uint8_t& frameTime, bool& fastForward, uint8_t& fastForwardRate, bool& takeScreenshot)
 {
     if(!GUI::showSettings)
         return;
@@ -66,6 +84,12 @@ void GUI::drawSettings(Chip8& chip8, uint8_t& frameTime, bool& takeScreenshot)
         {
             GUI::drawSpeed(frameTime);
 
+            GUI::drawAutoSpeed(chip8, autoSpeed);
+
+            GUI::drawRunAhead(chip8);
+
+            GUI::drawFastForward(fastForward, fastForwardRate);
+
             ImGui::EndTabItem();
         }
 
@@ -89,7 +113,7 @@ void GUI::drawSettings(Chip8& chip8, uint8_t& frameTime, bool& takeScreenshot)
     ImGui::End();
 }
 
-void GUI::drawCPU(Chip8& chip8)
+void GUI::drawCPU(Chip8& chip8, History& history)
 {
     if(!GUI::showDebugWindows)
         return;
@@ -152,7 +176,27 @@ void GUI::drawCPU(Chip8& chip8)
 
         ImGui::Spacing();
 
-        ImGui::Checkbox("Paused", &chip8.paused);
+        if(ImGui::Checkbox("Paused", &chip8.paused) && !chip8.paused)
+            chip8.resume();
+
+        ImGui::Checkbox("Skip Idle Loops", &chip8.skipIdleLoops);
+
+        ImGui::Spacing();
+
+        bool recording = chip8.recorder.isRecording();
+
+        if(ImGui::Checkbox("Record Trace", &recording))
+        {
+            if(recording)
+                chip8.recorder.start("trace.c8t");
+            else
+                chip8.recorder.stop();
+        }
+
+        if(chip8.recorder.isRecording())
+            ImGui::Text("Records: %llu", static_cast<unsigned long long>(chip8.recorder.recordCount));
+        else if(ImGui::Button("Open Trace"))
+            GUI::showTrace = GUI::traceIndex.open("trace.c8t");
 
         ImGui::Spacing();
 
@@ -180,6 +224,51 @@ void GUI::drawCPU(Chip8& chip8)
 
             if(ImGui::Button("Apply"))
                 chip8.cpu.pc = static_cast<uint16_t>(newPC);
+
+            ImGui::Spacing();
+
+            // Replaying while recording would write the re-executed instructions into the trace
+            ImGui::BeginDisabled(chip8.recorder.isRecording());
+
+            if(ImGui::Button("Step Back"))
+                history.stepBack(chip8);
+
+            ImGui::SameLine();
+
+            if(ImGui::Button("Back To Frame"))
+                history.stepBackToFrame(chip8);
+
+            if(ImGui::Button("Reverse Continue"))
+                history.reverseContinue(chip8, [](Chip8& machine) { return machine.breakpoints.hits(machine.cpu, machine.memory); });
+
+            ImGui::EndDisabled();
+
+            if(ImGui::Button("Step Into"))
+                history.stepForward(chip8);
+
+            ImGui::SameLine();
+
+            if(ImGui::Button("Step Over"))
+                chip8.stepOver();
+
+            ImGui::SameLine();
+
+            if(ImGui::Button("Step Out"))
+                chip8.stepOut();
+
+            ImGui::Text("Breakpoints: %u", chip8.breakpoints.getCount());
+
+            ImGui::SameLine();
+
+            if(ImGui::Button("Clear"))
+                chip8.breakpoints.clearAll();
+
+            if(ImGui::Button("Watchpoints"))
+                GUI::showWatchpoints = !GUI::showWatchpoints;
+
+            ImGui::Text("Instr: %llu", static_cast<unsigned long long>(chip8.instructionCount));
+            ImGui::Text("Idle skipped: %llu", static_cast<unsigned long long>(chip8.skippedInstructions));
+            ImGui::Text("Replay: %.2f ms", history.lastReplayTime);
         }
 
         ImGui::EndTable();
@@ -201,19 +290,101 @@ void GUI::drawDisassembly(Chip8& chip8)
 
     ImGui::Begin("Disassembly", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
 
-    Disassembler disassembler;
+    if(chip8.memory.romLoaded && (GUI::analysis == nullptr || GUI::analysis->romHash != chip8.memory.romHash))
+        GUI::analysis = Analysis::get(chip8.memory);
+
+    const uint16_t end = std::min<uint32_t>(CPU::pcStart + chip8.memory.romSize, Memory::memorySize);
+
+    GUI::disassemblyCache.layout(chip8.memory.romLoaded ? GUI::analysis.get() : nullptr, end, chip8.cpu.pc);
+
+    // Follow the PC only when it moves so the view can be scrolled while paused
+    static uint16_t lastPC = 0;
+
+    const bool followPC = chip8.cpu.pc != lastPC;
+
+    lastPC = chip8.cpu.pc;
 
-    std::vector<std::string> instructions = disassembler.disassemble(chip8.memory);
+    // Only the visible rows are disassembled and submitted, plus the PC row when it has to be scrolled to
+    ImGuiListClipper clipper;
 
-    for(uint16_t i = 0; i < instructions.size(); ++i)
+    clipper.Begin(GUI::disassemblyCache.getRowCount());
+
+    const uint16_t pcRow = GUI::disassemblyCache.getLine(chip8.cpu.pc);
+
+    if(followPC && pcRow != DisassemblyCache::noRow)
+        clipper.IncludeItemByIndex(pcRow);
+
+    while(clipper.Step())
     {
-        if(i == (chip8.cpu.pc - CPU::pcStart) / 2)
+        for(int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
         {
-            ImGui::TextColored(ImColor{255, 0, 0, 255}, "%s", instructions.at(i).c_str());
-            ImGui::SetScrollHereY();
+            const uint16_t address = GUI::disassemblyCache.getAddress(i);
+
+            const char* line = GUI::disassemblyCache.get(chip8.memory, address);
+
+            ImGui::PushID(address);
+
+            // Clicking the gutter toggles a breakpoint, right-clicking the line runs to it
+            const bool breakpoint = chip8.breakpoints.test(address);
+
+            const char* marker = !breakpoint ? " " : chip8.breakpoints.getCondition(address) != nullptr ? "?" : "*";
+
+            if(ImGui::Selectable(marker, breakpoint, ImGuiSelectableFlags_None, {10, 0}))
+                chip8.breakpoints.toggle(address);
+
+            ImGui::SameLine();
+
+            // The layout always starts a row at the PC, odd or not
+            if(address == chip8.cpu.pc)
+            {
+                ImGui::TextColored(ImColor{255, 0, 0, 255}, "%s", line);
+
+                if(followPC)
+                    ImGui::SetScrollHereY();
+            }
+            else if(chip8.paused && chip8.watchpoints.triggered && address == chip8.watchpoints.hit.pc)
+                ImGui::TextColored(ImColor{255, 200, 0, 255}, "%s", line);
+            else if(!GUI::disassemblyCache.isCode(address))
+                ImGui::TextDisabled("%s", line); // Never reached by the control-flow analysis, most likely sprite data
+            else
+                ImGui::Text("%s", line);
+
+            if(ImGui::BeginPopupContextItem("Line"))
+            {
+                if(ImGui::MenuItem("Run To Cursor"))
+                    chip8.runTo(address);
+
+                static char condition[128];
+                static std::string conditionError;
+
+                if(ImGui::IsWindowAppearing())
+                {
+                    const Condition* existing = chip8.breakpoints.getCondition(address);
+
+                    std::snprintf(condition, sizeof(condition), "%s", existing != nullptr ? existing->source.c_str() : "");
+
+                    conditionError.clear();
+                }
+
+                // Conditions are compiled here, once, not on every hit
+                ImGui::InputText("Condition", condition, sizeof(condition));
+
+                if(ImGui::Button("Set Breakpoint"))
+                {
+                    conditionError.clear();
+
+                    if(chip8.breakpoints.setCondition(address, condition, conditionError))
+                        ImGui::CloseCurrentPopup();
+                }
+
+                if(!conditionError.empty())
+                    ImGui::TextColored(ImColor{255, 0, 0, 255}, "%s", conditionError.c_str());
+
+                ImGui::EndPopup();
+            }
+
+            ImGui::PopID();
         }
-        else
-            ImGui::Text("%s", instructions.at(i).c_str());
     }
 
     ImGui::End();
@@ -234,11 +405,71 @@ void GUI::drawMemoryEditor(Memory& memory)
 
     ImGui::Begin("Memory Editor", nullptr, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
 
+#ifdef CHIP8_MEMORY_TRACKING
+    ImGui::Checkbox("Heatmap", &memory.trackAccesses);
+
+    if(memory.trackAccesses)
+    {
+        memoryEditor.UserData = &memory;
+        memoryEditor.BgColorFn = GUI::memoryHeatColor;
+        memoryEditor.HighlightFn = GUI::memoryRecentlyWritten;
+
+        float hottestPageHeat = 0.0f;
+        uint16_t hottestPage = 0;
+
+        for(uint16_t page = 0; page < Memory::memorySize; page += 0x100)
+        {
+            float pageHeat = 0.0f;
+
+            for(uint16_t i = page; i < page + 0x100; ++i)
+                pageHeat += memory.writeHeat[i];
+
+            if(pageHeat > hottestPageHeat)
+            {
+                hottestPageHeat = pageHeat;
+                hottestPage = page;
+            }
+        }
+
+        ImGui::SameLine();
+
+        ImGui::Text("Hottest write page: %03X", hottestPage);
+    }
+    else
+    {
+        memoryEditor.BgColorFn = nullptr;
+        memoryEditor.HighlightFn = nullptr;
+    }
+#endif
+
     memoryEditor.DrawContents(memory.getData(), Memory::memorySize);
 
     ImGui::End();
 }
 
+#ifdef CHIP8_MEMORY_TRACKING
+ImU32 GUI::memoryHeatColor(const ImU8*, size_t offset, void* userData)
+{
+    Memory& memory = *static_cast<Memory*>(userData);
+
+    const float reads = std::min(memory.readHeat[offset] / 8.0f, 1.0f);
+    const float writes = std::min(memory.writeHeat[offset] / 8.0f, 1.0f);
+
+    if(reads == 0.0f && writes == 0.0f)
+        return 0;
+
+    // Reads tint towards blue, writes towards red
+    return IM_COL32(static_cast<int>(writes * 255), 0, static_cast<int>(reads * 255), static_cast<int>(std::max(reads, writes) * 160));
+}
+
+bool GUI::memoryRecentlyWritten(const ImU8*, size_t offset, void* userData)
+{
+    Memory& memory = *static_cast<Memory*>(userData);
+
+    return memory.writeHeat[offset] > Memory::recentWriteHeat;
+}
+#endif
+
 void GUI::drawROMs(Chip8& chip8)
 {
     static char rom[64];
@@ -276,7 +507,13 @@ void GUI::drawSpeed(uint8_t& instructionsPerSecond)
 
     static int value = 11;
 
-    ImGui::DragInt("Instructions Per Second", &value, 0.1, 0, 64);
+    static uint8_t synced = 11; // Speed value last matched
+
+    // Follow changes made elsewhere, such as by auto speed, without losing an edit waiting for Apply
+    if(instructionsPerSecond != synced)
+        value = instructionsPerSecond;
+
+    ImGui::DragInt("Instructions Per Second", &value, 0.1, 0, AutoSpeed::maximumIPS);
 
     ImGui::Checkbox("Apply Immediately", &applyImmediately);
 
@@ -292,6 +529,89 @@ void GUI::drawSpeed(uint8_t& instructionsPerSecond)
             instructionsPerSecond = value;
         }
     }
+
+    synced = instructionsPerSecond;
+}
+
+void GUI::drawAutoSpeed(Chip8& chip8, AutoSpeed& autoSpeed)
+{
+    ImGui::SeparatorText("Auto Speed");
+
+    ImGui::Checkbox("Tune Speed Per ROM", &autoSpeed.enabled);
+
+    ImGui::Text("Current: %u instructions per frame", chip8.instructionsPerSecond);
+
+    switch(autoSpeed.status)
+    {
+        case AutoSpeed::Status::Off:
+            ImGui::TextDisabled(autoSpeed.enabled && !chip8.skipIdleLoops ? "Off, tuning needs Skip Idle Loops" : "Off");
+            break;
+
+        case AutoSpeed::Status::Tuning:
+            ImGui::Text("Tuning: %u / %u frames, %.2f draws per frame", autoSpeed.getProgress(), AutoSpeed::observedFrames, autoSpeed.drawsPerFrame);
+            break;
+
+        case AutoSpeed::Status::Stored:
+            ImGui::Text("Using the speed stored for this ROM");
+            break;
+
+        case AutoSpeed::Status::Tuned:
+            ImGui::Text("Tuned and stored for this ROM");
+            break;
+
+        case AutoSpeed::Status::Manual:
+            ImGui::Text("Set by hand, not stored");
+            break;
+    }
+
+    if(autoSpeed.enabled && chip8.memory.romLoaded && ImGui::Button("Retune"))
+        autoSpeed.forget(chip8);
+}
+
+void GUI::drawRunAhead(Chip8& chip8)
+{
+    ImGui::SeparatorText("Run-Ahead");
+
+    int frames = chip8.runAheadFrames;
+
+    // Each frame of run-ahead hides a frame of input lag but costs a savestate round trip and a frame of emulation
+    if(ImGui::SliderInt("Frames Ahead", &frames, 0, Chip8::maxRunAheadFrames))
+        chip8.runAheadFrames = frames;
+
+    ImGui::TextDisabled("Cost is shown as Run-ahead in the frame time overlay");
+}
+
+void GUI::drawFastForward(bool& fastForward, uint8_t& fastForwardRate)
+{
+    ImGui::SeparatorText("Fast-Forward");
+
+    ImGui::Checkbox("Fast-Forward (T, or hold Tab)", &fastForward);
+
+    static constexpr std::array<const char*, 5> rateNames {"Uncapped", "2x", "4x", "8x", "16x"};
+
+    // Index 0 is uncapped, index n is 2^n frames per host frame
+    int rate = 0;
+
+    while(rate + 1 < static_cast<int>(rateNames.size()) && (1 << (rate + 1)) <= fastForwardRate)
+        ++rate;
+
+    if(ImGui::Combo("Rate", &rate, rateNames.data(), rateNames.size()))
+        fastForwardRate = rate == 0 ? 0 : 1 << rate;
+}
+
+void GUI::drawFastForwardRate(float speed)
+{
+    if(speed <= 0.0f)
+        return;
+
+    ImGui::SetNextWindowPos({8, 8});
+    ImGui::SetNextWindowBgAlpha(0.5f);
+
+    ImGui::Begin("##FastForward", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoInputs | ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav);
+
+    ImGui::Text(">> %.1fx", speed);
+
+    ImGui::End();
 }
 
 void GUI::drawImage(Display& display, bool& takeScreenshot)
@@ -368,19 +688,312 @@ void GUI::drawHelp()
     }
 }
 
-void GUI::draw(SDL_Renderer* renderer, Chip8& chip8, uint8_t& instructionsPerSecond, bool& takeScreenshot)
+void GUI::drawTrace(Chip8& chip8)
 {
+    if(!GUI::showTrace || !GUI::traceIndex.isOpen())
+        return;
+
+    ImGui::Begin("Trace", &GUI::showTrace, ImGuiWindowFlags_AlwaysAutoResize);
+
+    ImGui::Text("Records: %llu", static_cast<unsigned long long>(GUI::traceIndex.getRecordCount()));
+    ImGui::Text("Frames: %u to %u", GUI::traceIndex.getFirstFrame(), GUI::traceIndex.getFirstFrame() + GUI::traceIndex.getFrameCount() - 1);
+
+    static int pc = CPU::pcStart;
+    static int frame = 0;
+    static int writer = 0;
+    static int64_t found = TraceIndex::notFound;
+
+    ImGui::SeparatorText("Queries");
+
+    ImGui::InputInt("Before Frame", &frame);
+
+    const int64_t frameStart = GUI::traceIndex.findFrame(frame);
+    const uint64_t before = frameStart == TraceIndex::notFound ? GUI::traceIndex.getRecordCount() : frameStart;
+
+    ImGui::InputInt("PC", &pc, 0, 0, ImGuiInputTextFlags_CharsHexadecimal);
+
+    if(ImGui::Button("Last Execution"))
+        found = GUI::traceIndex.findLastExecution(pc, before);
+
+    static const char* writerNames[Recorder::writerCount] {"V0", "V1", "V2", "V3", "V4", "V5", "V6", "V7", "V8", "V9", "VA", "VB", "VC", "VD", "VE", "VF", "I"};
+
+    ImGui::Combo("Register", &writer, writerNames, Recorder::writerCount);
+
+    if(ImGui::Button("Last Writer"))
+        found = GUI::traceIndex.findLastWriter(writer, before);
+
+    ImGui::SameLine();
+
+    if(ImGui::Button("Frame Start") && frameStart != TraceIndex::notFound)
+        found = frameStart + 1;
+
+    ImGui::SeparatorText("Result");
+
+    Recorder::Record record;
+
+    if(found == TraceIndex::notFound || !GUI::traceIndex.getRecord(found, record))
+    {
+        ImGui::TextDisabled("None");
+        ImGui::End();
+        return;
+    }
+
+    ImGui::Text("Record %lld, frame %u, PC %X: %04X", static_cast<long long>(found), record.frame, record.pc, record.word);
+
+    if(chip8.recorder.isRecording())
+        ImGui::TextDisabled("Stop recording to jump");
+    else if(ImGui::Button("Jump"))
+    {
+        chip8.paused = true;
+
+        if(!GUI::traceIndex.seek(chip8, found))
+            Logger::log(Logger::Level::Warning, "Couldn't replay to trace record {}", found);
+    }
+
+    ImGui::End();
+}
+
+void GUI::drawWatchpoints(Chip8& chip8)
+{
+    if(!GUI::showWatchpoints)
+        return;
+
+    ImGui::Begin("Watchpoints", &GUI::showWatchpoints, ImGuiWindowFlags_AlwaysAutoResize);
+
+    static int start = 0;
+    static int end = 0;
+    static bool read = false;
+    static bool write = true;
+    static bool change = false;
+
+    ImGui::InputInt("Start", &start, 0, 0, ImGuiInputTextFlags_CharsHexadecimal);
+    ImGui::InputInt("End", &end, 0, 0, ImGuiInputTextFlags_CharsHexadecimal);
+
+    ImGui::Checkbox("Read", &read);
+
+    ImGui::SameLine();
+
+    ImGui::Checkbox("Write", &write);
+
+    ImGui::SameLine();
+
+    ImGui::Checkbox("Change", &change);
+
+    if(ImGui::Button("Add") && (read || write || change))
+        chip8.watchpoints.add(chip8.memory, start, end, (read ? Watchpoints::Read : 0) | (write ? Watchpoints::Write : 0) | (change ? Watchpoints::Change : 0));
+
+    ImGui::SeparatorText("Watches");
+
+    const std::vector<Watchpoints::Watch>& watches = chip8.watchpoints.getWatches();
+
+    for(size_t i = 0; i < watches.size(); ++i)
+    {
+        const Watchpoints::Watch& watch = watches[i];
+
+        ImGui::PushID(i);
+
+        ImGui::Text("%03X-%03X %c%c%c", watch.start, watch.end, watch.kinds & Watchpoints::Read ? 'R' : '-', watch.kinds & Watchpoints::Write ? 'W' : '-', watch.kinds & Watchpoints::Change ? 'C' : '-');
+
+        ImGui::SameLine();
+
+        const bool removed = ImGui::SmallButton("Remove");
+
+        ImGui::PopID();
+
+        if(removed)
+        {
+            chip8.watchpoints.remove(chip8.memory, i);
+            break;
+        }
+    }
+
+    if(chip8.paused && chip8.watchpoints.triggered)
+    {
+        static const char* kindNames[] {"", "Read", "Write", "", "Change"};
+
+        const Watchpoints::Hit& hit = chip8.watchpoints.hit;
+
+        ImGui::SeparatorText("Hit");
+
+        ImGui::Text("%s of %03X by %03X: %02X -> %02X", kindNames[hit.kind], hit.address, hit.pc, hit.oldValue, hit.newValue);
+    }
+
+    ImGui::End();
+}
+
+void GUI::drawFrameTimes(Profiler& profiler, PerfCounters& perfCounters, Latency& latency)
+{
+    if(!GUI::showFrameTimes)
+        return;
+
+    ImGui::SetNextWindowBgAlpha(0.75f);
+
+    ImGui::Begin("Frame Times", &GUI::showFrameTimes, ImGuiWindowFlags_AlwaysAutoResize);
+
+    const uint32_t frameCount = profiler.getFrameCount();
+
+    if(frameCount == 0)
+    {
+        ImGui::End();
+        return;
+    }
+
+    const Profiler::Frame& frame = profiler.getFrame(0);
+
+    for(uint8_t i = 0; i < Profiler::phaseCount; ++i)
+        ImGui::Text("%-10s %6.2f ms", Profiler::phaseNames[i], frame.phases[i]);
+
+    ImGui::Text("%-10s %6.2f ms", "Frame", frame.interval);
+
+    float onePercent, pointOnePercent;
+
+    profiler.getLows(onePercent, pointOnePercent);
+
+    ImGui::Separator();
+
+    ImGui::Text("1%% low:   %6.2f ms", onePercent);
+    ImGui::Text("0.1%% low: %6.2f ms", pointOnePercent);
+    ImGui::Text("Missed deadlines: %u", profiler.missedDeadlines);
+    ImGui::Text("Process CPU: %5.1f%%%s", profiler.cpuUsage * 100.0f, profiler.idle ? " (idle)" : "");
+
+    if(Allocations::isCounting())
+        ImGui::Text("Heap allocations: %u (steady-state frames allocating: %u)", frame.allocations, profiler.allocatingFrames);
+
+    ImGui::Text("Frame arena: %zu / %zu KB", GUI::frameArena.highWater / 1024, FrameArena::arenaSize / 1024);
+
+    // Frame intervals in 1 ms buckets from 0 to 49 ms, the last bucket catching everything slower
+    constexpr size_t bucketCount = 50;
+
+    float* histogram = GUI::frameArena.allocate<float>(bucketCount);
+
+    if(histogram != nullptr)
+    {
+        std::fill(histogram, histogram + bucketCount, 0.0f);
+
+        for(uint32_t age = 0; age < frameCount; ++age)
+        {
+            const size_t bucket = std::min(static_cast<size_t>(profiler.getFrame(age).interval), bucketCount - 1);
+
+            ++histogram[bucket];
+        }
+
+        ImGui::PlotHistogram("##Histogram", histogram, bucketCount, 0, "Frame time (0-50 ms)", 0.0f, FLT_MAX, {300, 60});
+    }
+
+    ImGui::Separator();
+
+    if(ImGui::Button("Dump"))
+        profiler.dump("frametimes.csv");
+
+    ImGui::SameLine();
+
+    ImGui::Checkbox("Dump On Hitch", &profiler.dumpOnHitch);
+
+#ifdef CHIP8_TRACING
+    if(ImGui::Button("Write Trace"))
+        Trace::flush("trace.json");
+#endif
+
+    GUI::drawPerfCounters(perfCounters);
+
+    GUI::drawLatency(latency);
+
+    ImGui::End();
+}
+
+void GUI::drawLatency(Latency& latency)
+{
+    ImGui::SeparatorText("Input To Photon");
+
+    ImGui::Text("Presses: %u (no response: %u)", latency.getSampleCount(), latency.timeouts);
+
+    if(latency.getSampleCount() > 0)
+    {
+        ImGui::Text("Last: %5.1f ms, frame %llu -> %llu", latency.getSample(0).milliseconds, static_cast<unsigned long long>(latency.getSample(0).consumedFrame), static_cast<unsigned long long>(latency.getSample(0).presentedFrame));
+        ImGui::Text("p50 %3.0f ms, p95 %3.0f ms, p99 %3.0f ms", latency.getPercentile(0.5f), latency.getPercentile(0.95f), latency.getPercentile(0.99f));
+    }
+
+    float* histogram = GUI::frameArena.allocate<float>(Latency::bucketCount);
+
+    if(histogram != nullptr)
+    {
+        std::copy(latency.histogram.begin(), latency.histogram.end(), histogram);
+
+        ImGui::PlotHistogram("##Latency", histogram, Latency::bucketCount, 0, "Latency (0-100 ms)", 0.0f, FLT_MAX, {300, 60});
+    }
+
+    if(ImGui::Button("Export"))
+        latency.dump("latency.csv");
+
+    ImGui::SameLine();
+
+    if(ImGui::Button("Clear##Latency"))
+        latency.clear();
+}
+
+void GUI::drawPerfCounters(PerfCounters& perfCounters)
+{
+    ImGui::SeparatorText("Host Counters");
+
+    bool enabled = perfCounters.isOpen();
+
+    if(ImGui::Checkbox("Sample Per Frame", &enabled))
+    {
+        if(enabled)
+            enabled = perfCounters.open();
+        else
+            perfCounters.close();
+    }
+
+    if(!perfCounters.isOpen())
+    {
+        if(enabled)
+            ImGui::TextDisabled("perf_event_open unavailable");
+
+        return;
+    }
+
+    const PerfCounters::Sample& last = perfCounters.last;
+    const PerfCounters::Sample& total = perfCounters.total;
+
+    ImGui::Text("Core: %s (%s counters)", last.core ? last.core : "-", perfCounters.hardware ? "hardware" : "software");
+
+    ImGui::Text("Emulated instructions: %llu", static_cast<unsigned long long>(last.emulatedInstructions));
+
+    if(perfCounters.hardware)
+    {
+        ImGui::Text("Host IPC:             %6.2f (avg %6.2f)", last.getIPC(), total.getIPC());
+        ImGui::Text("Host instrs / instr:  %6.1f", total.getPerEmulated(PerfCounters::Counter::Instructions));
+        ImGui::Text("Branch misses / instr:%6.3f", total.getPerEmulated(PerfCounters::Counter::BranchMisses));
+        ImGui::Text("Cache misses / instr: %6.3f", total.getPerEmulated(PerfCounters::Counter::CacheMisses));
+    }
+
+    ImGui::Text("CPU ns / instr:       %6.1f", total.getPerEmulated(PerfCounters::Counter::TaskClock));
+}
+
+void GUI::draw(SDL_Renderer* renderer, Chip8& chip8, History& history, Profiler& profiler, PerfCounters& perfCounters, Latency& latency, AutoSpeed& autoSpeed, uint8_t& instructionsPerSecond, bool& fastForward, uint8_t& fastForwardRate, float fastForwardSpeed, bool& takeScreenshot)
+{
+    GUI::frameArena.reset();
+
     ImGui_ImplSDLRenderer2_NewFrame();
     ImGui_ImplSDL2_NewFrame();
     ImGui::NewFrame();
 
-    GUI::drawSettings(chip8, instructionsPerSecond, takeScreenshot);
+    GUI::drawSettings(chip8, autoSpeed, instructionsPerSecond, fastForward, fastForwardRate, takeScreenshot);
+
+    GUI::drawFastForwardRate(fastForwardSpeed);
     
     GUI::drawMemoryEditor(chip8.memory);
 
     GUI::drawDisassembly(chip8);
 
-    GUI::drawCPU(chip8);
+    GUI::drawCPU(chip8, history);
+
+    GUI::drawTrace(chip8);
+
+    GUI::drawWatchpoints(chip8);
+
+    GUI::drawFrameTimes(profiler, perfCounters, latency);
 
     ImGui::Render();
 
@@ -25,7 +25,17 @@
 #include "../deps/imgui/backends/imgui_impl_sdlrenderer2.h"
 #include "../deps/imgui/imgui_memory_editor.h"
 
+#include "analysis.h"
+#include "arena.h"
+#include "autospeed.h"
 #include "disassembler.h"
+#include "disassemblycache.h"
+#include "history.h"
+#include "latency.h"
+#include "profiler.h"
+#include "traceindex.h"
+#include "perfcounters.h"
+#include "trace.h"
 
 namespace GUI
 {
@@ -34,6 +44,19 @@ namespace GUI
 
     extern bool showDebugWindows;
 
+    extern bool showFrameTimes;
+
+    extern FrameArena frameArena; // Reset at the start of every GUI frame
+
+    extern DisassemblyCache disassemblyCache;
+
+    extern std::shared_ptr<const Analysis> analysis; // Code and data map of the loaded ROM
+
+    extern TraceIndex traceIndex;
+    extern bool showTrace;
+
+    extern bool showWatchpoints;
+
     const ImVec2 memoryEditorSize = {418, Display::displayHeight * Display::displayScale};
     const ImVec2 disassemblySize = {418, Display::displayHeight * Display::displayScale};
     const ImVec2 cpuContentsSize = {Display::displayWidth * Display::displayScaleMinimized, (Display::displayHeight * Display::displayScale) - (Display::displayHeight * Display::displayScaleMinimized)};
@@ -56,21 +79,45 @@ namespace GUI
 
     void processEvent(SDL_Event event);
 
-    void drawSettings(Chip8& chip8, uint8_t& instructionsPerSecond, bool& takeScreenshot);
+    void drawSettings(Chip8& chip8, AutoSpeed& autoSpeed, uint8_t& instructionsPerSecond, bool& fastForward, uint8_t& fastForwardRate, bool& takeScreenshot);
 
-    void drawCPU(Chip8& chip8);
+    void drawCPU(Chip8& chip8, History& history);
 
     void drawDisassembly(Chip8& chip8);
 
     void drawMemoryEditor(Memory& memory);
 
+#ifdef CHIP8_MEMORY_TRACKING
+    ImU32 memoryHeatColor(const ImU8* data, size_t offset, void* userData);
+
+    bool memoryRecentlyWritten(const ImU8* data, size_t offset, void* userData);
+#endif
+
     void drawROMs(Chip8& chip8);
 
     void drawSpeed(uint8_t& frameTime);
 
+    void drawRunAhead(Chip8& chip8);
+
+    void drawAutoSpeed(Chip8& chip8, AutoSpeed& autoSpeed);
+
+    void drawFastForward(bool& fastForward, uint8_t& fastForwardRate);
+
+    void drawFastForwardRate(float speed);
+
     void drawImage(Display& display, bool& takeScreenshot);
 
     void drawHelp();
 
-    void draw(SDL_Renderer* renderer, Chip8& chip8, uint8_t& frameTime, bool& takeScreenshot);
+    void drawTrace(Chip8& chip8);
+
+    void drawWatchpoints(Chip8& chip8);
+
+    void drawFrameTimes(Profiler& profiler, PerfCounters& perfCounters, Latency& latency);
+
+    void drawPerfCounters(PerfCounters& perfCounters);
+
+    void drawLatency(Latency& latency);
+
+    void draw(SDL_Renderer* renderer, Chip8& chip8, History& history, Profiler& profiler, PerfCounters& perfCounters, Latency& latency, AutoSpeed& autoSpeed, uint8_t& frameTime, bool& fastForward, uint8_t& fastForwardRate, float fastForwardSpeed, bool& takeScreenshot); // fastForwardSpeed is 0 unless fast-forwarding
 };
\ No newline at end of file
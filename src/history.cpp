@@ -0,0 +1,283 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "history.h"
+#include "logger.h"
+#include "trace.h"
+#include <chrono>
+
+History::History() : snapshots(new Chip8::State[History::snapshotCapacity]), frames(new FrameInput[History::frameCapacity]), replaying(false), replayRate(0.0f), interval(History::minimumInterval * 16), lastReplayTime(0.0f)
+{
+    this->clear();
+}
+
+void History::clear()
+{
+    this->snapshotStart = 0;
+    this->snapshotCount = 0;
+
+    this->frameStart = 0;
+    this->frameCount = 0;
+
+    this->lastSnapshot = 0;
+}
+
+Chip8::State& History::getSnapshot(uint16_t index)
+{
+    return this->snapshots[(this->snapshotStart + index) % History::snapshotCapacity];
+}
+
+History::FrameInput& History::getFrame(uint32_t index)
+{
+    return this->frames[(this->frameStart + index) % History::frameCapacity];
+}
+
+void History::beginFrame(Chip8& chip8, uint16_t keys, const Chip8::KeyEvent* events, uint8_t eventCount)
+{
+    // Frames re-executed by a seek are already in the log
+    if(this->replaying)
+        return;
+
+    // Running from an earlier point discards the old future
+    while(this->frameCount > 0 && this->getFrame(this->frameCount - 1).frame >= chip8.frameCount)
+        --this->frameCount;
+
+    // The machine may have been edited since, so a snapshot at this exact point is retaken too
+    while(this->snapshotCount > 0 && this->getSnapshot(this->snapshotCount - 1).instructionCount >= chip8.instructionCount)
+        --this->snapshotCount;
+
+    // A jump the log can't explain, such as a trace seek or a ROM load, starts a new history
+    if(this->frameCount > 0)
+    {
+        const FrameInput& last = this->getFrame(this->frameCount - 1);
+
+        if(last.frame + 1 != chip8.frameCount || last.firstInstruction + last.instructions != chip8.instructionCount)
+            this->clear();
+    }
+
+    if(this->snapshotCount > 0)
+        this->lastSnapshot = this->getSnapshot(this->snapshotCount - 1).instructionCount;
+
+    if(this->snapshotCount == 0 || chip8.instructionCount - this->lastSnapshot >= this->interval)
+    {
+        if(this->snapshotCount == History::snapshotCapacity)
+        {
+            this->snapshotStart = (this->snapshotStart + 1) % History::snapshotCapacity;
+            --this->snapshotCount;
+        }
+
+        chip8.saveState(this->getSnapshot(this->snapshotCount++));
+
+        this->lastSnapshot = chip8.instructionCount;
+    }
+
+    if(this->frameCount == History::frameCapacity)
+    {
+        this->frameStart = (this->frameStart + 1) % History::frameCapacity;
+        --this->frameCount;
+    }
+
+    FrameInput& frame = this->getFrame(this->frameCount++);
+
+    frame.frame = chip8.frameCount;
+    frame.firstInstruction = chip8.instructionCount;
+    frame.keys = keys;
+    frame.instructions = chip8.instructionsPerSecond;
+    frame.eventCount = eventCount;
+
+    std::copy(events, events + eventCount, frame.events.begin());
+}
+
+int32_t History::findSnapshot(uint64_t instruction)
+{
+    if(this->frameCount == 0)
+        return -1;
+
+    const uint64_t oldestFrame = this->getFrame(0).frame;
+
+    for(int32_t i = this->snapshotCount - 1; i >= 0; --i)
+    {
+        const Chip8::State& snapshot = this->getSnapshot(i);
+
+        // Snapshots older than the input log can't be replayed
+        if(snapshot.frameCount < oldestFrame)
+            return -1;
+
+        if(snapshot.instructionCount <= instruction)
+            return i;
+    }
+
+    return -1;
+}
+
+int64_t History::findFrame(uint64_t instruction)
+{
+    uint32_t low = 0;
+    uint32_t high = this->frameCount;
+
+    while(low < high)
+    {
+        const uint32_t middle = low + (high - low) / 2;
+
+        if(this->getFrame(middle).firstInstruction <= instruction)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    if(low == 0)
+        return -1;
+
+    return low - 1;
+}
+
+uint64_t History::getOldestInstruction()
+{
+    if(this->frameCount == 0)
+        return UINT64_MAX;
+
+    for(uint16_t i = 0; i < this->snapshotCount; ++i)
+    {
+        if(this->getSnapshot(i).frameCount >= this->getFrame(0).frame)
+            return this->getSnapshot(i).instructionCount;
+    }
+
+    return UINT64_MAX;
+}
+
+bool History::advance(Chip8& chip8)
+{
+    if(this->frameCount == 0)
+        return false;
+
+    const uint64_t index = chip8.frameCount - this->getFrame(0).frame;
+
+    if(chip8.frameCount < this->getFrame(0).frame || index >= this->frameCount)
+        return false;
+
+    const FrameInput& frame = this->getFrame(index);
+
+    if(chip8.frameInstruction == 0)
+        chip8.beginFrame(frame.keys, frame.events.data(), frame.eventCount);
+
+    chip8.step();
+
+    if(chip8.frameInstruction >= frame.instructions)
+        chip8.endFrame();
+
+    return true;
+}
+
+bool History::replay(Chip8& chip8, uint16_t snapshot, uint64_t instruction)
+{
+    chip8.loadState(this->getSnapshot(snapshot));
+
+    this->replaying = true;
+
+    while(chip8.instructionCount < instruction)
+    {
+        if(!this->advance(chip8))
+            break;
+    }
+
+    this->replaying = false;
+
+    // Accesses made while re-executing aren't new hits
+    chip8.watchpoints.triggered = false;
+
+    return chip8.instructionCount == instruction;
+}
+
+void History::tuneInterval(uint64_t instructions, float milliseconds)
+{
+    // Short replays are dominated by the snapshot copy and say little about emulation speed
+    if(instructions < History::minimumInterval || milliseconds <= 0.0f)
+        return;
+
+    const float rate = instructions / milliseconds;
+
+    this->replayRate = this->replayRate == 0.0f ? rate : this->replayRate * 0.9f + rate * 0.1f;
+
+    // A seek replays at most one interval plus a frame, so size the interval to the budget
+    this->interval = std::clamp<uint64_t>(static_cast<uint64_t>(this->replayRate * History::replayBudget), History::minimumInterval, History::maximumInterval);
+}
+
+bool History::seek(Chip8& chip8, uint64_t instruction)
+{
+    TRACE_ZONE("History::seek");
+
+    const int32_t snapshot = this->findSnapshot(instruction);
+
+    if(snapshot < 0)
+        return false;
+
+    const int64_t frame = this->findFrame(instruction);
+
+    // Only instructions covered by the input log are reachable
+    if(frame < 0 || instruction > this->getFrame(frame).firstInstruction + this->getFrame(frame).instructions)
+        return false;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    const uint64_t replayed = instruction - this->getSnapshot(snapshot).instructionCount;
+
+    const bool reached = this->replay(chip8, snapshot, instruction);
+
+    this->lastReplayTime = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::steady_clock::now() - start).count();
+
+    this->tuneInterval(replayed, this->lastReplayTime);
+
+    if(!reached)
+        Logger::log(Logger::Level::Warning, "History seek stopped at instruction {} instead of {}", chip8.instructionCount, instruction);
+
+    return reached;
+}
+
+bool History::stepBack(Chip8& chip8)
+{
+    if(chip8.instructionCount == 0)
+        return false;
+
+    return this->seek(chip8, chip8.instructionCount - 1);
+}
+
+bool History::stepBackToFrame(Chip8& chip8)
+{
+    if(chip8.frameInstruction > 0)
+        return this->seek(chip8, chip8.instructionCount - chip8.frameInstruction);
+
+    const int64_t frame = this->findFrame(chip8.instructionCount - 1);
+
+    if(chip8.instructionCount == 0 || frame < 0)
+        return false;
+
+    return this->seek(chip8, this->getFrame(frame).firstInstruction);
+}
+
+bool History::stepForward(Chip8& chip8)
+{
+    // The logged future is kept until new input is latched
+    this->replaying = true;
+
+    const bool logged = this->advance(chip8);
+
+    this->replaying = false;
+
+    if(!logged)
+        chip8.advance();
+
+    return true;
+}
@@ -0,0 +1,144 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <memory>
+
+#include "chip8.h"
+
+// Reverse execution for the debugger. Snapshots are taken at the first frame boundary after every
+// 'interval' instructions and the input of every frame is logged, so any earlier instruction can be
+// reached by loading the snapshot before it and re-executing deterministically.
+
+class History
+{
+    public:
+        static constexpr uint16_t snapshotCapacity = 1024;
+        static constexpr uint32_t frameCapacity = 1 << 16; // Frames of input kept, about 18 minutes at 60 Hz
+
+        static constexpr float replayBudget = 8.0f; // Milliseconds a reverse step may spend replaying
+
+        static constexpr uint64_t minimumInterval = 256;
+        static constexpr uint64_t maximumInterval = 1 << 22;
+
+    private:
+        struct FrameInput
+        {
+            uint64_t frame;
+            uint64_t firstInstruction;
+
+            uint16_t keys;
+
+            uint8_t instructions;
+
+            uint8_t eventCount;
+
+            std::array<Chip8::KeyEvent, Chip8::maxKeyEvents> events;
+        };
+
+        std::unique_ptr<Chip8::State[]> snapshots; // Ring, oldest at snapshotStart
+        uint16_t snapshotStart;
+        uint16_t snapshotCount;
+
+        std::unique_ptr<FrameInput[]> frames; // Ring, oldest at frameStart
+        uint32_t frameStart;
+        uint32_t frameCount;
+
+        uint64_t lastSnapshot; // Instruction count of the newest snapshot
+
+        bool replaying;
+
+        float replayRate; // Measured replay speed in instructions per millisecond, 0 until the first replay
+
+    private:
+        Chip8::State& getSnapshot(uint16_t index);
+
+        FrameInput& getFrame(uint32_t index);
+
+        int32_t findSnapshot(uint64_t instruction); // Newest snapshot at or before the instruction, -1 if none
+
+        int64_t findFrame(uint64_t instruction); // Frame containing the instruction, -1 if none
+
+        bool replay(Chip8& chip8, uint16_t snapshot, uint64_t instruction);
+
+        void tuneInterval(uint64_t instructions, float milliseconds);
+
+    public:
+        uint64_t interval; // Instructions between snapshots, tuned to the replay budget
+
+        float lastReplayTime; // Milliseconds the last reverse operation took
+
+    public:
+        History();
+
+        void clear();
+
+        void beginFrame(Chip8& chip8, uint16_t keys, const Chip8::KeyEvent* events, uint8_t eventCount); // Called by Chip8 before latching the keys
+
+        uint64_t getOldestInstruction();
+
+        bool seek(Chip8& chip8, uint64_t instruction); // Leaves chip8 about to execute the instruction
+
+        bool stepBack(Chip8& chip8);
+
+        bool stepBackToFrame(Chip8& chip8); // Back to the start of the current frame, or the previous one when already there
+
+        // Back to the most recent earlier instruction at which stop(chip8) holds
+        template<typename Predicate>
+        bool reverseContinue(Chip8& chip8, Predicate stop)
+        {
+            const uint64_t target = chip8.instructionCount;
+
+            for(int32_t snapshot = this->findSnapshot(target == 0 ? 0 : target - 1); snapshot >= 0; --snapshot)
+            {
+                const uint64_t segmentEnd = snapshot + 1 < this->snapshotCount ? std::min(this->getSnapshot(snapshot + 1).instructionCount, target) : target;
+
+                if(!this->replay(chip8, snapshot, this->getSnapshot(snapshot).instructionCount))
+                    break;
+
+                // Replay the segment one instruction at a time, remembering the last stop before the target
+                int64_t found = -1;
+
+                this->replaying = true;
+
+                while(chip8.instructionCount < segmentEnd)
+                {
+                    if(stop(chip8))
+                        found = chip8.instructionCount;
+
+                    if(!this->advance(chip8))
+                        break;
+                }
+
+                this->replaying = false;
+
+                if(found >= 0)
+                    return this->seek(chip8, found);
+            }
+
+            // Nothing found, go back to where we started
+            this->seek(chip8, target);
+
+            return false;
+        }
+
+        bool advance(Chip8& chip8); // One instruction forward following the logged input, false past the end of the log
+
+        bool stepForward(Chip8& chip8); // Re-executes logged input after stepping back, or runs live at the end of the log
+};
@@ -157,7 +157,11 @@ void Instructions::JMP_V0(CPU& cpu, uint16_t nnn)
 
 void Instructions::RND(CPU& cpu, uint8_t x, uint8_t nn)
 {
-    cpu.v.at(x) = rand() & nn;
+    cpu.rngState ^= cpu.rngState << 13;
+    cpu.rngState ^= cpu.rngState >> 17;
+    cpu.rngState ^= cpu.rngState << 5;
+
+    cpu.v.at(x) = (cpu.rngState >> 8) & nn;
 }
 
 void Instructions::DRW(Display& display, Memory& memory, CPU& cpu, uint8_t x, uint8_t y, uint8_t n)
@@ -174,6 +178,8 @@ void Instructions::DRW(Display& display, Memory& memory, CPU& cpu, uint8_t x, ui
 
         uint8_t spriteByte = memory[cpu.i + row];
 
+        memory.trackRead(cpu.i + row);
+
         for(uint8_t col = 0; col < 8; ++col)
         {
             if(xPos + col >= Display::displayWidth)
@@ -196,13 +202,13 @@ void Instructions::DRW(Display& display, Memory& memory, CPU& cpu, uint8_t x, ui
 
 void Instructions::SKP(Keypad& keypad, CPU& cpu, uint8_t x)
 {
-    if(keypad[(cpu.v.at(x) & 0xF)])
+    if(keypad.isPressed(cpu.v.at(x) & 0xF))
         cpu.pc += 2;
 }
 
 void Instructions::SKNP(Keypad& keypad, CPU& cpu, uint8_t x)
 {
-    if(!keypad[(cpu.v.at(x) & 0xF)])
+    if(!keypad.isPressed(cpu.v.at(x) & 0xF))
         cpu.pc += 2;
 }
 
@@ -211,22 +217,26 @@ void Instructions::LD_VX_DT(CPU& cpu, uint8_t x)
     cpu.v.at(x) = cpu.delayTimer;
 }
 
-void Instructions::LD_VX_K(Keypad& keypad, CPU& cpu, uint8_t x)
+bool Instructions::LD_VX_K(Keypad& keypad, CPU& cpu, uint8_t x)
 {
-    bool released = false;
+    const uint16_t released = keypad.getReleased();
 
-    for(uint8_t i = 0; i < Keypad::keyCount; ++i)
+    if(released == 0)
     {
-        if(keypad.oldKeys.at(i) && !keypad[i])
-        {
-            cpu.v.at(x) = i;
+        cpu.pc -= 2;
 
-            released = true;
-        }
+        return false;
     }
 
-    if(!released)
-        cpu.pc -= 2;
+    // The highest key wins when several were released together
+    uint8_t key = Keypad::keyCount - 1;
+
+    while(!((released >> key) & 1))
+        --key;
+
+    cpu.v.at(x) = key;
+
+    return true;
 }
 
 void Instructions::LD_DT_VX(CPU& cpu, uint8_t x)
@@ -251,21 +261,35 @@ void Instructions::LD_F_VX(CPU& cpu, uint8_t x)
 
 void Instructions::LD_B_VX(Memory& memory, CPU& cpu, uint8_t x)
 {
+    memory.trackWrite(cpu.i + 2, cpu.v.at(x) % 10);
+
     memory[cpu.i + 2] = cpu.v.at(x) % 10;
 
+    memory.trackWrite(cpu.i + 1, (cpu.v.at(x) / 10) % 10);
+
     memory[cpu.i + 1] = (cpu.v.at(x) / 10) % 10;
 
+    memory.trackWrite(cpu.i, cpu.v.at(x) / 100);
+
     memory[cpu.i] = cpu.v.at(x) / 100;
 }
 
 void Instructions::LD_MI_VX(Memory& memory, CPU& cpu, uint8_t x)
 {
     for(uint8_t i = 0; i <= x; ++i)
+    {
+        memory.trackWrite(cpu.i + i, cpu.v.at(i));
+
         memory[(cpu.i + i) & 0xFFF] = cpu.v.at(i);
+    }
 }
 
 void Instructions::LD_VX_MI(Memory& memory, CPU& cpu, uint8_t x)
 {
     for(uint8_t i = 0; i <= x; ++i)
+    {
         cpu.v.at(i) = memory[(cpu.i + i) & 0xFFF];
+
+        memory.trackRead(cpu.i + i);
+    }
 }
@@ -52,7 +52,7 @@ namespace Instructions
     void SKP(Keypad& keypad, CPU& cpu, uint8_t x); // Skip the next instruction if the key stored in reg x is pressed
     void SKNP(Keypad& keypad, CPU& cpu, uint8_t x); // Skip the next instruction if the key stored in reg x is not pressed
     void LD_VX_DT(CPU& cpu, uint8_t x); // Set reg x to the value of the delay timer
-    void LD_VX_K(Keypad& keypad, CPU& cpu, uint8_t x); // Set reg x to the value of an awaited key release
+    bool LD_VX_K(Keypad& keypad, CPU& cpu, uint8_t x); // Set reg x to the value of an awaited key release, false while still waiting
     void LD_DT_VX(CPU& cpu, uint8_t x); // Set the delay timer to reg x
     void LD_ST_VX(CPU& cpu, uint8_t x); // Set the sound timer to reg x
     void ADD_I_VX(CPU& cpu, uint8_t x); // Add the value of reg x to the index register
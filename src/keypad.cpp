@@ -23,32 +23,38 @@ Keypad::Keypad()
 
 void Keypad::reset()
 {
-    for(auto& key : this->keys)
-        key = false;
-
-    for(auto& key : this->oldKeys)
-        key = false;
+    this->keys = 0;
+    this->oldKeys = 0;
 }
 
-bool& Keypad::operator[](uint8_t key)
+uint16_t Keypad::getKeyboardMask(const Uint8* keys)
 {
-    return this->keys.at(key);
+    uint16_t mask = 0;
+
+    for(uint8_t i = 0; i < Keypad::keyCount; ++i)
+        mask |= (keys[Keypad::scancodes.at(i)] != 0) << i;
+
+    return mask;
 }
 
-void Keypad::setKey(uint8_t key, bool activated)
+int8_t Keypad::getKey(SDL_Scancode scancode)
 {
-    if(key >= Keypad::keyCount)
-        return;
+    for(uint8_t i = 0; i < Keypad::keyCount; ++i)
+    {
+        if(Keypad::scancodes.at(i) == scancode)
+            return i;
+    }
 
-    this->oldKeys.at(key) = this->keys.at(key);
+    return -1;
+}
 
-    this->keys.at(key) = activated;
+void Keypad::updateMask(uint16_t mask)
+{
+    this->oldKeys = this->keys;
+    this->keys = mask;
 }
 
-void Keypad::update(const Uint8* keys)
+uint16_t Keypad::getMask() const
 {
-    for(uint8_t i = 0; i < this->keyCount; ++i)
-    {
-        this->setKey(i, keys[Keypad::scancodes.at(i)] != 0);
-    }
-}
\ No newline at end of file
+    return this->keys;
+}
@@ -48,19 +48,30 @@ class Keypad
         };
 
     private:
-        std::array<bool, Keypad::keyCount> keys;
+        uint16_t keys; // Bit n set means key n is pressed
 
-    public:
-        std::array<bool, Keypad::keyCount> oldKeys;
+        uint16_t oldKeys; // Keys before the last update
 
     public:
         Keypad();
 
         void reset();
 
-        bool& operator[](uint8_t key);
+        bool isPressed(uint8_t key) const
+        {
+            return (this->keys >> key) & 1;
+        }
+
+        uint16_t getReleased() const // Keys the last update released
+        {
+            return this->oldKeys & ~this->keys;
+        }
+
+        static uint16_t getKeyboardMask(const Uint8* keys); // Keypad mask from an SDL keyboard state
+
+        static int8_t getKey(SDL_Scancode scancode); // Keypad key bound to the scancode, -1 if none
 
-        void setKey(uint8_t key, bool activated);
+        void updateMask(uint16_t mask);
 
-        void update(const Uint8* keys);
+        uint16_t getMask() const;
 };
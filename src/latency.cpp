@@ -0,0 +1,154 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "latency.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+Latency::Latency() : stage(Stage::Idle), current({}), presents(0), head(0), timeouts(0)
+{
+    this->samples.fill({});
+    this->histogram.fill(0);
+}
+
+void Latency::tag(uint32_t timestamp, Display& presented)
+{
+    if(this->stage != Stage::Idle)
+        return;
+
+    this->current = {};
+    this->current.timestamp = timestamp;
+
+    this->baseline = presented;
+
+    this->stage = Stage::Tagged;
+}
+
+void Latency::consume(uint64_t frame)
+{
+    if(this->stage != Stage::Tagged)
+        return;
+
+    this->current.consumedFrame = frame;
+
+    this->presents = 0;
+
+    this->stage = Stage::Consumed;
+}
+
+void Latency::discard()
+{
+    if(this->stage == Stage::Tagged)
+        this->stage = Stage::Idle;
+}
+
+void Latency::present(uint64_t frame, Display& presented, uint32_t now)
+{
+    if(this->stage != Stage::Consumed)
+        return;
+
+    const size_t size = sizeof(presented[0]) * Display::displayWidth * Display::displayHeight;
+
+    if(std::memcmp(presented.getData(), this->baseline.getData(), size) == 0)
+    {
+        if(++this->presents < Latency::timeoutFrames)
+            return;
+
+        ++this->timeouts;
+
+        this->stage = Stage::Idle;
+
+        return;
+    }
+
+    // Event timestamps come from the same millisecond clock
+    this->current.presentedFrame = frame;
+    this->current.milliseconds = static_cast<float>(now - this->current.timestamp);
+
+    this->samples[this->head & (Latency::historySize - 1)] = this->current;
+
+    ++this->head;
+
+    ++this->histogram[std::min(static_cast<size_t>(this->current.milliseconds), Latency::bucketCount - static_cast<size_t>(1))];
+
+    this->stage = Stage::Idle;
+}
+
+uint32_t Latency::getSampleCount() const
+{
+    return std::min<uint32_t>(this->head, Latency::historySize);
+}
+
+const Latency::Sample& Latency::getSample(uint32_t age) const
+{
+    return this->samples[(this->head - 1 - age) & (Latency::historySize - 1)];
+}
+
+float Latency::getPercentile(float percentile) const
+{
+    uint32_t total = 0;
+
+    for(uint32_t count : this->histogram)
+        total += count;
+
+    if(total == 0)
+        return 0.0f;
+
+    const uint32_t rank = static_cast<uint32_t>(total * percentile);
+
+    uint32_t seen = 0;
+
+    for(uint8_t bucket = 0; bucket < Latency::bucketCount; ++bucket)
+    {
+        seen += this->histogram[bucket];
+
+        if(seen > rank)
+            return bucket;
+    }
+
+    return Latency::bucketCount - 1;
+}
+
+void Latency::clear()
+{
+    this->stage = Stage::Idle;
+    this->head = 0;
+    this->timeouts = 0;
+
+    this->histogram.fill(0);
+}
+
+bool Latency::dump(const char* path) const
+{
+    std::ofstream file(path);
+
+    if(!file.is_open())
+        return false;
+
+    file << "sample,timestamp,consumed_frame,presented_frame,milliseconds\n";
+
+    const uint32_t count = this->getSampleCount();
+
+    for(uint32_t age = count; age-- > 0;)
+    {
+        const Sample& sample = this->getSample(age);
+
+        file << (count - 1 - age) << "," << sample.timestamp << "," << sample.consumedFrame << "," << sample.presentedFrame << "," << sample.milliseconds << "\n";
+    }
+
+    return true;
+}
@@ -0,0 +1,93 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <stdint.h>
+#include <array>
+
+#include "display.h"
+
+// Input-to-photon latency. A keypad press is tagged with its SDL timestamp and the picture on screen
+// at the time, then followed through the frame that consumed it to the first presented frame whose
+// picture differs. Only one press is followed at a time.
+
+class Latency
+{
+    public:
+        static constexpr uint16_t historySize = 1024; // Must be a power of two
+
+        static constexpr uint8_t bucketCount = 100; // 1 ms buckets, the last one catching everything slower
+
+        static constexpr uint8_t timeoutFrames = 60; // Presents to wait for a response before giving up on a press
+
+        struct Sample
+        {
+            uint32_t timestamp; // SDL ticks of the key event
+
+            uint64_t consumedFrame; // Emulated frame that applied the press
+
+            uint64_t presentedFrame; // Emulated frame on screen when the picture changed
+
+            float milliseconds; // From the key event until SDL_RenderPresent returned
+        };
+
+    private:
+        enum class Stage : uint8_t
+        {
+            Idle,
+            Tagged, // Waiting for a frame to apply the press
+            Consumed, // Waiting for the picture to change
+        };
+
+        Stage stage;
+
+        Sample current;
+
+        Display baseline; // The picture on screen when the press was tagged
+
+        uint8_t presents; // Presents since the press was consumed
+
+        std::array<Sample, Latency::historySize> samples; // Ring buffer of finished measurements
+
+        uint32_t head; // Number of samples ever written
+
+    public:
+        std::array<uint32_t, Latency::bucketCount> histogram;
+
+        uint32_t timeouts; // Presses the picture never responded to
+
+    public:
+        Latency();
+
+        void tag(uint32_t timestamp, Display& presented); // A keypad press arrived
+
+        void consume(uint64_t frame); // A frame with the tagged press in its input was emulated
+
+        void discard(); // The tagged press never reached the machine
+
+        void present(uint64_t frame, Display& presented, uint32_t now); // SDL_RenderPresent returned at now, in SDL ticks
+
+        uint32_t getSampleCount() const;
+
+        const Sample& getSample(uint32_t age) const; // 0 is the most recent sample
+
+        float getPercentile(float percentile) const; // From the histogram, in milliseconds
+
+        void clear();
+
+        bool dump(const char* path) const;
+};
@@ -0,0 +1,332 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct Ring
+    {
+        std::array<Logger::Record, Logger::ringSize> records;
+
+        std::atomic<uint32_t> head {0}; // Written by the owning thread
+        std::atomic<uint32_t> tail {0}; // Written by the logging thread
+
+        std::atomic<uint32_t> dropped {0}; // Records lost to rate limiting or a full ring
+
+        // Token bucket, only touched by the owning thread
+        float tokens = Logger::rateBurst;
+        uint64_t lastRefill = 0;
+    };
+
+    const auto logStart = std::chrono::steady_clock::now();
+
+    std::atomic<Logger::Level> minimumLevel {Logger::Level::Info};
+
+    constexpr auto idleTimeout = std::chrono::seconds(1); // Longest a drop warning waits when nothing else wakes the worker
+
+    class Worker
+    {
+        private:
+            std::mutex mutex; // Guards rings and output, never taken by writers after registration
+
+            std::condition_variable drained;
+
+            std::mutex wakeMutex; // Only taken by writers when the worker is asleep
+
+            std::condition_variable pending;
+
+            std::atomic<bool> sleeping;
+
+            bool woken; // Guarded by wakeMutex
+
+            std::vector<std::unique_ptr<Ring>> rings;
+
+            std::FILE* output;
+
+            std::atomic<bool> running;
+
+            std::atomic<uint64_t> written; // Records ever taken off the rings, to wake flush()
+
+            std::thread thread;
+
+        private:
+            void print(const Logger::Record& record)
+            {
+                static constexpr std::array<const char*, 4> levelNames {"DEBUG", "INFO", "WARNING", "ERROR"};
+
+                std::fprintf(this->output, "[%10.3f] %s: ", record.timestamp / 1e9, levelNames[static_cast<uint8_t>(record.level)]);
+
+                uint8_t argument = 0;
+
+                for(const char* c = record.format; *c != 0; ++c)
+                {
+                    if(*c != '{')
+                    {
+                        std::fputc(*c, this->output);
+                        continue;
+                    }
+
+                    const char* end = std::strchr(c, '}');
+
+                    if(end == nullptr)
+                    {
+                        std::fputs(c, this->output);
+                        break;
+                    }
+
+                    const char kind = end - c > 1 ? c[1] : 'd';
+
+                    if(kind == 's')
+                        std::fputs(record.text.data(), this->output);
+                    else if(argument < record.argumentCount)
+                        std::fprintf(this->output, kind == 'x' ? "%llX" : "%llu", static_cast<unsigned long long>(record.arguments[argument++]));
+
+                    c = end;
+                }
+
+                std::fputc('\n', this->output);
+            }
+
+            bool drain()
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+
+                bool wroteAny = false;
+
+                for(auto& ring : this->rings)
+                {
+                    const uint32_t head = ring->head.load(std::memory_order_acquire);
+                    uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+
+                    for(; tail != head; ++tail)
+                    {
+                        this->print(ring->records[tail & (Logger::ringSize - 1)]);
+
+                        this->written.fetch_add(1, std::memory_order_relaxed);
+                    }
+
+                    ring->tail.store(tail, std::memory_order_release);
+
+                    const uint32_t dropped = ring->dropped.exchange(0, std::memory_order_relaxed);
+
+                    if(dropped != 0)
+                        std::fprintf(this->output, "[%10.3f] WARNING: %u log records dropped\n", std::chrono::duration<double>(std::chrono::steady_clock::now() - logStart).count(), dropped);
+
+                    wroteAny |= tail != head || dropped != 0;
+                }
+
+                if(wroteAny)
+                    std::fflush(this->output);
+
+                return wroteAny;
+            }
+
+            bool hasPending()
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+
+                for(auto& ring : this->rings)
+                    if(ring->head.load(std::memory_order_relaxed) != ring->tail.load(std::memory_order_relaxed))
+                        return true;
+
+                return false;
+            }
+
+            void sleep()
+            {
+                std::unique_lock<std::mutex> lock(this->wakeMutex);
+
+                this->sleeping.store(true, std::memory_order_relaxed);
+
+                // Pairs with the fence in wake(), either the writer sees sleeping or we see its record
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                if(!this->hasPending())
+                    this->pending.wait_for(lock, idleTimeout, [this] { return this->woken || !this->running.load(std::memory_order_relaxed); });
+
+                this->woken = false;
+
+                this->sleeping.store(false, std::memory_order_relaxed);
+            }
+
+            void run()
+            {
+                while(this->running.load(std::memory_order_relaxed))
+                {
+                    const bool wroteAny = this->drain();
+
+                    this->drained.notify_all();
+
+                    if(!wroteAny)
+                        this->sleep();
+                }
+
+                this->drain();
+            }
+
+        public:
+            Worker() : sleeping(false), woken(false), output(stderr), running(true), written(0)
+            {
+                this->thread = std::thread(&Worker::run, this);
+            }
+
+            ~Worker()
+            {
+                this->running.store(false);
+
+                {
+                    std::lock_guard<std::mutex> lock(this->wakeMutex);
+
+                    this->pending.notify_one();
+                }
+
+                this->thread.join();
+
+                if(this->output != stderr)
+                    std::fclose(this->output);
+            }
+
+            Ring* registerThread()
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+
+                this->rings.push_back(std::make_unique<Ring>());
+
+                return this->rings.back().get();
+            }
+
+            bool setOutput(const char* path)
+            {
+                std::FILE* file = path == nullptr ? stderr : std::fopen(path, "a");
+
+                if(file == nullptr)
+                    return false;
+
+                std::lock_guard<std::mutex> lock(this->mutex);
+
+                if(this->output != stderr)
+                    std::fclose(this->output);
+
+                this->output = file;
+
+                return true;
+            }
+
+            void wake()
+            {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                if(!this->sleeping.load(std::memory_order_relaxed))
+                    return;
+
+                std::lock_guard<std::mutex> lock(this->wakeMutex);
+
+                this->woken = true;
+
+                this->pending.notify_one();
+            }
+
+            void flush(const Ring* ring)
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+
+                this->drained.wait_for(lock, std::chrono::seconds(1), [ring]
+                {
+                    return ring->tail.load(std::memory_order_acquire) == ring->head.load(std::memory_order_acquire);
+                });
+            }
+    };
+
+    Worker& getWorker()
+    {
+        static Worker worker;
+
+        return worker;
+    }
+
+    Ring& getRing()
+    {
+        thread_local Ring* ring = getWorker().registerThread();
+
+        return *ring;
+    }
+}
+
+void Logger::setLevel(Level level)
+{
+    minimumLevel.store(level, std::memory_order_relaxed);
+}
+
+bool Logger::isEnabled(Level level)
+{
+    return level >= minimumLevel.load(std::memory_order_relaxed);
+}
+
+bool Logger::setOutput(const char* path)
+{
+    return getWorker().setOutput(path);
+}
+
+void Logger::setArgument(Record& record, const char* text)
+{
+    std::strncpy(record.text.data(), text, Logger::textSize - 1);
+
+    record.text[Logger::textSize - 1] = 0;
+}
+
+void Logger::write(Record& record)
+{
+    Ring& ring = getRing();
+
+    record.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - logStart).count();
+
+    ring.tokens = std::min<float>(Logger::rateBurst, ring.tokens + (record.timestamp - ring.lastRefill) * (Logger::rateLimit / 1e9f));
+    ring.lastRefill = record.timestamp;
+
+    const uint32_t head = ring.head.load(std::memory_order_relaxed);
+
+    // Errors bypass the rate limit so the reason for a crash is never lost
+    const bool limited = ring.tokens < 1.0f && record.level != Level::Error;
+
+    if(limited || head - ring.tail.load(std::memory_order_acquire) >= Logger::ringSize)
+    {
+        ring.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring.tokens = std::max(0.0f, ring.tokens - 1.0f);
+
+    ring.records[head & (Logger::ringSize - 1)] = record;
+
+    ring.head.store(head + 1, std::memory_order_release);
+
+    getWorker().wake();
+}
+
+void Logger::flush()
+{
+    getWorker().flush(&getRing());
+}
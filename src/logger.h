@@ -0,0 +1,100 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <atomic>
+#include <type_traits>
+
+// Asynchronous logger. Callers copy a fixed-size record into a per-thread ring without locking,
+// a background thread formats the records and writes them out.
+// Formats support {} for decimal integers, {x} for hexadecimal integers and {s} for one string.
+
+namespace Logger
+{
+    enum class Level : uint8_t
+    {
+        Debug,
+        Info,
+        Warning,
+        Error,
+    };
+
+    static constexpr uint8_t maxArguments = 4;
+    static constexpr uint8_t textSize = 64; // Strings are truncated to fit the record
+
+    static constexpr uint32_t ringSize = 1024; // Records per thread, must be a power of two
+
+    static constexpr uint32_t rateLimit = 100; // Records per second each thread may sustain
+    static constexpr uint32_t rateBurst = 200; // Records a thread may write at once before being limited
+
+    struct Record
+    {
+        Level level;
+
+        uint8_t argumentCount;
+
+        uint64_t timestamp; // Nanoseconds since the logger started
+
+        const char* format; // Must be a string literal
+
+        std::array<uint64_t, Logger::maxArguments> arguments;
+
+        std::array<char, Logger::textSize> text;
+    };
+
+    void setLevel(Level level);
+
+    bool setOutput(const char* path); // nullptr writes to stderr
+
+    void write(Record& record); // Fills in the timestamp and queues the record
+
+    void flush(); // Blocks until every queued record has been written
+
+    void setArgument(Record& record, const char* text);
+
+    template<typename T>
+    void setArgument(Record& record, T value)
+    {
+        static_assert(std::is_integral<T>::value || std::is_enum<T>::value, "Logger arguments must be integers or strings");
+
+        record.arguments[record.argumentCount++] = static_cast<uint64_t>(value);
+    }
+
+    bool isEnabled(Level level);
+
+    template<typename... Args>
+    void log(Level level, const char* format, Args... args)
+    {
+        static_assert(sizeof...(Args) <= Logger::maxArguments, "Too many logger arguments");
+
+        if(!Logger::isEnabled(level))
+            return;
+
+        Record record;
+
+        record.level = level;
+        record.argumentCount = 0;
+        record.format = format;
+        record.text[0] = 0;
+
+        (Logger::setArgument(record, args), ...);
+
+        Logger::write(record);
+    }
+};
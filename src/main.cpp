@@ -19,8 +19,7 @@
 #include <thread>
 
 #include "app.h"
-
-constexpr float frameTime = 16.6;
+#include "trace.h"
 
 int main(int argc, char* argv[])
 {
@@ -32,19 +31,52 @@ int main(int argc, char* argv[])
 
     while(!app.quit)
     {
+        // Paused, ROM-less or key-blocked, block on the event queue instead of spinning.
+        // Input wakes the loop straight away and the frame runs without waiting for the deadline.
+        // Minimized or hidden windows also block, but only until the deadline, which still paces them.
+        const bool idle = app.isIdle();
+
         auto currentTime = std::chrono::steady_clock::now();
 
         float deltaTime = std::chrono::duration<float, std::chrono::milliseconds::period>(currentTime - lastCycleTime).count();
 
-        if(deltaTime > frameTime)
+        const int waitTimeout = app.getWaitTimeout(deltaTime);
+
+        if(waitTimeout > 0)
+        {
+            SDL_WaitEventTimeout(nullptr, waitTimeout);
+
+            currentTime = std::chrono::steady_clock::now();
+
+            deltaTime = std::chrono::duration<float, std::chrono::milliseconds::period>(currentTime - lastCycleTime).count();
+        }
+
+        if(idle || deltaTime > App::frameTime)
         {
             lastCycleTime = currentTime;
 
+            TRACE_ZONE("Frame");
+
+            app.profiler.beginFrame();
+
             app.eventLoop();
 
+            app.profiler.endPhase(Profiler::Phase::Events);
+
             app.update();
 
-            app.draw();
+            app.profiler.endPhase(Profiler::Phase::Emulation);
+
+            app.runAhead();
+
+            app.profiler.endPhase(Profiler::Phase::RunAhead);
+
+            if(app.isVisible())
+                app.draw();
+
+            app.profiler.idle = idle;
+
+            app.profiler.endFrame();
         }
     }
 
@@ -15,9 +15,15 @@
 //     along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "memory.h"
+#include "logger.h"
+#include "trace.h"
 
-Memory::Memory() : romLoaded(false)
+Memory::Memory() : romSize(0), romHash(0), romLoaded(false), watchpoints(nullptr), watchedReadPages(0), watchedWritePages(0)
 {
+#ifdef CHIP8_MEMORY_TRACKING
+    this->trackAccesses = false;
+#endif
+
     this->reset();
 
     this->loadFont();
@@ -27,6 +33,11 @@ void Memory::reset()
 {
     for(auto& index : this->memory)
         index = 0;
+
+#ifdef CHIP8_MEMORY_TRACKING
+    this->readHeat.fill(0.0f);
+    this->writeHeat.fill(0.0f);
+#endif
 }
 
 uint8_t& Memory::operator[](uint16_t index)
@@ -44,11 +55,19 @@ uint16_t Memory::fetchWord(uint16_t pc)
     const uint8_t highByte = this->memory.at(pc);
     const uint8_t lowByte = this->memory.at(pc + 1);
 
+    this->trackRead(pc);
+    this->trackRead(pc + 1);
+
     const uint16_t word = (highByte << 8 | lowByte);
 
     return word;
 }
 
+uint16_t Memory::peekWord(uint16_t address)
+{
+    return this->memory[address & (Memory::memorySize - 1)] << 8 | this->memory[(address + 1) & (Memory::memorySize - 1)];
+}
+
 void Memory::loadFont()
 {
     if(Memory::fontset0.size() > Memory::fontsetSize)
@@ -58,34 +77,66 @@ void Memory::loadFont()
         this->memory.at(i) = Memory::fontset0.at(i);
 }
 
+void Memory::decayAccesses()
+{
+#ifdef CHIP8_MEMORY_TRACKING
+    if(!this->trackAccesses)
+        return;
+
+    // Flush small values to zero so cold addresses drop out of the heatmap
+    for(auto& heat : this->readHeat)
+        heat = heat > 0.01f ? heat * Memory::accessDecay : 0.0f;
+
+    for(auto& heat : this->writeHeat)
+        heat = heat > 0.01f ? heat * Memory::accessDecay : 0.0f;
+#endif
+}
+
+uint64_t Memory::hashROM(const uint8_t* data, size_t size)
+{
+    uint64_t hash = 0xCBF29CE484222325;
+
+    for(size_t i = 0; i < size; ++i)
+    {
+        hash ^= data[i];
+        hash *= 0x100000001B3;
+    }
+
+    return hash;
+}
+
 void Memory::loadROM(const char* romPath)
 {
+    TRACE_ZONE("Memory::loadROM");
+
     std::ifstream rom(romPath, std::ios::binary | std::ios::ate);
 
     if(rom.is_open())
     {
         std::streampos size = rom.tellg();
 
-        char* buffer = new char[size];
+        if(size > Memory::memorySize - CPU::pcStart)
+        {
+            Logger::log(Logger::Level::Error, "ROM too large: {s}", romPath);
 
-        rom.seekg(0, std::ios::beg);
-        rom.read(buffer, size);
-        rom.close();
+            this->romLoaded = false;
 
-        for(long i = 0; i < size; ++i)
-        {
-            this->memory.at(CPU::pcStart + i) = buffer[i];
+            return;
         }
 
-        delete[] buffer;
+        // Read straight into emulated memory instead of staging through a heap buffer
+        rom.seekg(0, std::ios::beg);
+        rom.read(reinterpret_cast<char*>(this->memory.data() + CPU::pcStart), size);
+        rom.close();
 
-        this->romSize = std::filesystem::file_size(romPath);
+        this->romSize = size;
+        this->romHash = Memory::hashROM(this->memory.data() + CPU::pcStart, this->romSize);
 
         this->romLoaded = true;
     }
     else
     {
-        std::cout << "Couldn't open ROM" << std::endl;
+        Logger::log(Logger::Level::Error, "Couldn't open ROM: {s}", romPath);
 
         this->romLoaded = false;
     }
@@ -22,6 +22,7 @@
 #include <iostream>
 
 #include "cpu.h"
+#include "watchpoints.h"
 
 class Memory
 {
@@ -57,9 +58,28 @@ class Memory
     public:
         size_t romSize;
 
+        uint64_t romHash; // Identifies the loaded ROM for per-ROM caches and settings
+
     public:
         bool romLoaded;
 
+    public:
+        Watchpoints* watchpoints; // Consulted only for accesses on watched pages
+
+        uint64_t watchedReadPages; // Bit n covers addresses n * 64 to n * 64 + 63
+        uint64_t watchedWritePages;
+
+#ifdef CHIP8_MEMORY_TRACKING
+    public:
+        static constexpr float accessDecay = 0.9f; // Applied to the access counters once per frame
+        static constexpr float recentWriteHeat = 0.5f; // Write counters above this count as recently written
+
+        bool trackAccesses;
+
+        std::array<float, Memory::memorySize> readHeat; // Decaying read counters per address
+        std::array<float, Memory::memorySize> writeHeat; // Decaying write counters per address
+#endif
+
     public:
         Memory();
 
@@ -71,7 +91,42 @@ class Memory
 
         uint16_t fetchWord(uint16_t pc);
 
+        uint16_t peekWord(uint16_t address); // Like fetchWord but invisible to the heatmap and watchpoints, for tools
+
         void loadFont();
 
         void loadROM(const char* romPath);
-};
\ No newline at end of file
+
+        static uint64_t hashROM(const uint8_t* data, size_t size); // 64-bit FNV-1a
+
+        // Access hooks for watchpoints, and for the heatmap when CHIP8_MEMORY_TRACKING is defined
+        void trackRead(uint16_t address);
+        void trackWrite(uint16_t address, uint8_t value); // Called before the value is stored
+        void decayAccesses();
+};
+
+inline void Memory::trackRead(uint16_t address)
+{
+    address &= Memory::memorySize - 1;
+
+#ifdef CHIP8_MEMORY_TRACKING
+    if(this->trackAccesses)
+        this->readHeat[address] += 1.0f;
+#endif
+
+    if((this->watchedReadPages >> (address / Watchpoints::pageSize)) & 1)
+        this->watchpoints->checkRead(address, this->memory[address]);
+}
+
+inline void Memory::trackWrite(uint16_t address, uint8_t value)
+{
+    address &= Memory::memorySize - 1;
+
+#ifdef CHIP8_MEMORY_TRACKING
+    if(this->trackAccesses)
+        this->writeHeat[address] += 1.0f;
+#endif
+
+    if((this->watchedWritePages >> (address / Watchpoints::pageSize)) & 1)
+        this->watchpoints->checkWrite(address, this->memory[address], value);
+}
\ No newline at end of file
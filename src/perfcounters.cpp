@@ -0,0 +1,215 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "perfcounters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+double PerfCounters::Sample::getIPC() const
+{
+    const uint8_t cycles = static_cast<uint8_t>(Counter::Cycles);
+    const uint8_t instructions = static_cast<uint8_t>(Counter::Instructions);
+
+    if(!this->valid[cycles] || !this->valid[instructions] || this->values[cycles] == 0)
+        return 0.0;
+
+    return static_cast<double>(this->values[instructions]) / this->values[cycles];
+}
+
+double PerfCounters::Sample::getPerEmulated(Counter counter) const
+{
+    if(!this->valid[static_cast<uint8_t>(counter)] || this->emulatedInstructions == 0)
+        return 0.0;
+
+    return static_cast<double>(this->values[static_cast<uint8_t>(counter)]) / this->emulatedInstructions;
+}
+
+PerfCounters::PerfCounters() : groupFD(-1), hardware(false)
+{
+    this->fds.fill(-1);
+    this->startValues.fill(0);
+
+    this->last = {};
+    this->total = {};
+}
+
+PerfCounters::~PerfCounters()
+{
+    this->close();
+}
+
+bool PerfCounters::openCounter(Counter counter, uint32_t type, uint64_t config)
+{
+#ifdef __linux__
+    perf_event_attr attr;
+
+    std::memset(&attr, 0, sizeof(attr));
+
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = this->groupFD == -1; // The leader starts the whole group
+    attr.exclude_kernel = 1; // Lets unprivileged users count with perf_event_paranoid <= 2
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID;
+
+    const int fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, this->groupFD, 0));
+
+    if(fd == -1)
+        return false;
+
+    if(this->groupFD == -1)
+        this->groupFD = fd;
+
+    this->fds[static_cast<uint8_t>(counter)] = fd;
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool PerfCounters::open()
+{
+#ifdef __linux__
+    this->close();
+
+    this->hardware = this->openCounter(Counter::Cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+
+    if(this->hardware)
+    {
+        this->openCounter(Counter::Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        this->openCounter(Counter::BranchMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        this->openCounter(Counter::CacheMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    }
+
+    // Virtual machines and containers often hide the PMU, CPU time still tells whether a change helped
+    this->openCounter(Counter::TaskClock, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK);
+
+    if(this->groupFD == -1)
+        return false;
+
+    ioctl(this->groupFD, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(this->groupFD, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+    this->last = {};
+    this->total = {};
+
+    for(uint8_t i = 0; i < PerfCounters::counterCount; ++i)
+        this->total.valid[i] = this->last.valid[i] = this->fds[i] != -1;
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+void PerfCounters::close()
+{
+#ifdef __linux__
+    // Members close before the leader
+    for(int& fd : this->fds)
+    {
+        if(fd != -1 && fd != this->groupFD)
+            ::close(fd);
+
+        fd = -1;
+    }
+
+    if(this->groupFD != -1)
+        ::close(this->groupFD);
+#endif
+
+    this->groupFD = -1;
+    this->hardware = false;
+}
+
+bool PerfCounters::isOpen() const
+{
+    return this->groupFD != -1;
+}
+
+bool PerfCounters::readGroup(std::array<uint64_t, PerfCounters::counterCount>& values)
+{
+#ifdef __linux__
+    struct
+    {
+        uint64_t count;
+
+        struct
+        {
+            uint64_t value;
+            uint64_t id;
+        } entries[PerfCounters::counterCount];
+    } group;
+
+    if(::read(this->groupFD, &group, sizeof(group)) <= 0)
+        return false;
+
+    // Group entries come back in the order the counters were opened, which skips the ones that failed
+    uint64_t entry = 0;
+
+    for(uint8_t i = 0; i < PerfCounters::counterCount && entry < group.count; ++i)
+    {
+        if(this->fds[i] == -1)
+            continue;
+
+        values[i] = group.entries[entry++].value;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+void PerfCounters::beginFrame()
+{
+    if(!this->isOpen())
+        return;
+
+    this->readGroup(this->startValues);
+}
+
+void PerfCounters::endFrame(const char* core, uint64_t emulatedInstructions)
+{
+    if(!this->isOpen())
+        return;
+
+    std::array<uint64_t, PerfCounters::counterCount> values {};
+
+    if(!this->readGroup(values))
+        return;
+
+    this->last.core = core;
+    this->last.emulatedInstructions = emulatedInstructions;
+
+    this->total.core = core;
+    this->total.emulatedInstructions += emulatedInstructions;
+
+    for(uint8_t i = 0; i < PerfCounters::counterCount; ++i)
+    {
+        this->last.values[i] = values[i] - this->startValues[i];
+
+        this->total.values[i] += this->last.values[i];
+    }
+}
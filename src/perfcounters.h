@@ -0,0 +1,85 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <stdint.h>
+#include <array>
+
+// Host performance counters read around each emulated frame through perf_event_open.
+// Falls back to software counters when hardware events are unavailable, and to nothing off Linux.
+
+class PerfCounters
+{
+    public:
+        enum class Counter : uint8_t
+        {
+            Cycles,
+            Instructions,
+            BranchMisses,
+            CacheMisses,
+            TaskClock, // Software fallback, nanoseconds of CPU time
+            Count,
+        };
+
+        static constexpr uint8_t counterCount = static_cast<uint8_t>(PerfCounters::Counter::Count);
+
+        struct Sample
+        {
+            const char* core; // Execution core that ran the frame
+
+            uint64_t emulatedInstructions;
+
+            std::array<uint64_t, PerfCounters::counterCount> values;
+
+            std::array<bool, PerfCounters::counterCount> valid;
+
+            double getIPC() const; // Host instructions per host cycle
+            double getPerEmulated(Counter counter) const; // Host events per emulated instruction
+        };
+
+    private:
+        int groupFD; // Leader of the counter group, -1 when closed
+
+        std::array<int, PerfCounters::counterCount> fds;
+
+        std::array<uint64_t, PerfCounters::counterCount> startValues;
+
+        bool readGroup(std::array<uint64_t, PerfCounters::counterCount>& values);
+
+        bool openCounter(Counter counter, uint32_t type, uint64_t config);
+
+    public:
+        bool hardware; // False when only software counters could be opened
+
+        Sample last; // The most recently finished frame
+
+        Sample total; // Accumulated since the counters were opened
+
+    public:
+        PerfCounters();
+        ~PerfCounters();
+
+        bool open();
+
+        void close();
+
+        bool isOpen() const;
+
+        void beginFrame();
+
+        void endFrame(const char* core, uint64_t emulatedInstructions);
+};
@@ -0,0 +1,219 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#include "allocations.h"
+#include "logger.h"
+
+Profiler::Profiler(float deadline) : head(0), frameStartAllocations(0), hitchFrames(new Frame[Profiler::historySize]), hitchCount(0), lastHitchDump(0), writingHitch(false), deadline(deadline), missedDeadlines(0), dumpOnHitch(false), allocatingFrames(0), idle(false), cpuUsage(0.0f)
+{
+    this->frames.fill({});
+    this->current = {};
+
+    this->frameStart = std::chrono::steady_clock::now();
+    this->phaseStart = this->frameStart;
+
+    this->usageStart = this->frameStart;
+    this->usageClock = std::clock();
+}
+
+Profiler::~Profiler()
+{
+    if(this->hitchWriter.joinable())
+        this->hitchWriter.join();
+}
+
+void Profiler::beginFrame()
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    this->current = {};
+    this->current.interval = std::chrono::duration<float, std::chrono::milliseconds::period>(now - this->frameStart).count();
+
+    this->frameStart = now;
+    this->phaseStart = now;
+
+    this->frameStartAllocations = Allocations::getCount();
+}
+
+void Profiler::endPhase(Phase phase)
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    const float elapsed = std::chrono::duration<float, std::chrono::milliseconds::period>(now - this->phaseStart).count();
+
+    this->current.phases[static_cast<uint8_t>(phase)] += elapsed;
+    this->current.work += elapsed;
+
+    this->phaseStart = now;
+}
+
+void Profiler::endFrame()
+{
+    const uint32_t index = this->head.load(std::memory_order_relaxed);
+
+    this->current.allocations = Allocations::getCount() - this->frameStartAllocations;
+
+    if(index >= Profiler::warmupFrames && this->current.allocations != 0)
+    {
+        if(this->allocatingFrames == 0)
+            Logger::log(Logger::Level::Warning, "{} heap allocations in steady-state frame {}", this->current.allocations, index);
+
+        ++this->allocatingFrames;
+    }
+
+    this->frames[index & (Profiler::historySize - 1)] = this->current;
+
+    // Readers on other threads only look at frames older than the published head
+    this->head.store(index + 1, std::memory_order_release);
+
+    const auto now = std::chrono::steady_clock::now();
+
+    const float usageElapsed = std::chrono::duration<float>(now - this->usageStart).count();
+
+    if(usageElapsed >= 1.0f)
+    {
+        const std::clock_t clock = std::clock();
+
+        this->cpuUsage = static_cast<float>(clock - this->usageClock) / CLOCKS_PER_SEC / usageElapsed;
+
+        this->usageStart = now;
+        this->usageClock = clock;
+    }
+
+    // The first interval measures the time since construction, not a frame
+    if(index == 0 || this->idle || this->current.interval <= this->deadline * 1.5f)
+        return;
+
+    ++this->missedDeadlines;
+
+    if(!this->dumpOnHitch)
+        return;
+
+    this->dumpHitch(index);
+}
+
+void Profiler::dumpHitch(uint32_t index)
+{
+    // Writing lengthens the following frames, which would otherwise be dumped as hitches in turn
+    if(this->lastHitchDump != 0 && index - this->lastHitchDump < Profiler::historySize)
+        return;
+
+    if(this->writingHitch.load(std::memory_order_acquire))
+        return;
+
+    if(this->hitchWriter.joinable())
+        this->hitchWriter.join();
+
+    this->lastHitchDump = index;
+
+    this->hitchCount = this->getFrameCount();
+
+    for(uint32_t age = this->hitchCount; age-- > 0;)
+        this->hitchFrames[this->hitchCount - 1 - age] = this->getFrame(age);
+
+    this->writingHitch.store(true, std::memory_order_release);
+
+    this->hitchWriter = std::thread([this, index]
+    {
+        char path[32];
+
+        std::snprintf(path, sizeof(path), "hitch-%u.csv", index);
+
+        Profiler::writeFrames(path, this->hitchFrames.get(), this->hitchCount);
+
+        this->writingHitch.store(false, std::memory_order_release);
+    });
+}
+
+uint32_t Profiler::getFrameCount() const
+{
+    return std::min<uint32_t>(this->head.load(std::memory_order_acquire), Profiler::historySize);
+}
+
+const Profiler::Frame& Profiler::getFrame(uint32_t age) const
+{
+    const uint32_t index = this->head.load(std::memory_order_acquire) - 1 - age;
+
+    return this->frames[index & (Profiler::historySize - 1)];
+}
+
+void Profiler::getLows(float& onePercent, float& pointOnePercent)
+{
+    const uint32_t count = this->getFrameCount();
+
+    if(count == 0)
+    {
+        onePercent = 0.0f;
+        pointOnePercent = 0.0f;
+        return;
+    }
+
+    for(uint32_t i = 0; i < count; ++i)
+        this->sorted[i] = this->getFrame(i).interval;
+
+    std::sort(this->sorted.begin(), this->sorted.begin() + count);
+
+    // The lows are the frame times only 1% and 0.1% of frames exceed
+    onePercent = this->sorted[std::min(count - 1, count * 99 / 100)];
+    pointOnePercent = this->sorted[std::min(count - 1, count * 999 / 1000)];
+}
+
+bool Profiler::dump(const char* path) const
+{
+    const uint32_t count = this->getFrameCount();
+
+    std::vector<Frame> frames(count);
+
+    for(uint32_t age = count; age-- > 0;)
+        frames[count - 1 - age] = this->getFrame(age);
+
+    return Profiler::writeFrames(path, frames.data(), count);
+}
+
+bool Profiler::writeFrames(const char* path, const Frame* frames, uint32_t count)
+{
+    std::ofstream file(path);
+
+    if(!file.is_open())
+        return false;
+
+    file << "frame,interval,work,allocations";
+
+    for(const char* name : Profiler::phaseNames)
+        file << "," << name;
+
+    file << "\n";
+
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        const Frame& frame = frames[i];
+
+        file << i << "," << frame.interval << "," << frame.work << "," << frame.allocations;
+
+        for(float phase : frame.phases)
+            file << "," << phase;
+
+        file << "\n";
+    }
+
+    return true;
+}
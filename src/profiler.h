@@ -0,0 +1,127 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <memory>
+#include <thread>
+
+class Profiler
+{
+    public:
+        enum class Phase : uint8_t
+        {
+            Events,
+            Emulation,
+            RunAhead,
+            Render,
+            GUI,
+            Present,
+            Count,
+        };
+
+        static constexpr uint8_t phaseCount = static_cast<uint8_t>(Profiler::Phase::Count);
+
+        static constexpr std::array<const char*, Profiler::phaseCount> phaseNames
+        {
+            "Events",
+            "Emulation",
+            "Run-ahead",
+            "Render",
+            "GUI",
+            "Present",
+        };
+
+        static constexpr uint16_t historySize = 1024; // Must be a power of two
+
+        struct Frame
+        {
+            std::array<float, Profiler::phaseCount> phases; // Milliseconds spent in each phase
+
+            float work; // Milliseconds spent on all phases
+
+            float interval; // Milliseconds since the previous frame started
+
+            uint32_t allocations; // Heap allocations made during the frame, 0 unless counting
+        };
+
+        static constexpr uint16_t warmupFrames = 120; // Frames allowed to allocate before the steady state
+
+    private:
+        std::array<Frame, Profiler::historySize> frames; // Ring buffer of finished frames
+
+        std::atomic<uint32_t> head; // Number of frames ever written, published after each frame
+
+        std::array<float, Profiler::historySize> sorted; // Scratch space for the percentile lows
+
+        Frame current;
+
+        std::chrono::steady_clock::time_point frameStart;
+        std::chrono::steady_clock::time_point phaseStart;
+
+        uint64_t frameStartAllocations;
+
+        std::chrono::steady_clock::time_point usageStart;
+        std::clock_t usageClock;
+
+        // Hitch dumps are copied here and written off the main thread, at most one per historySize frames
+        std::unique_ptr<Frame[]> hitchFrames;
+        uint32_t hitchCount;
+        uint32_t lastHitchDump;
+        std::thread hitchWriter;
+        std::atomic<bool> writingHitch;
+
+    private:
+        static bool writeFrames(const char* path, const Frame* frames, uint32_t count); // Oldest frame first
+
+        void dumpHitch(uint32_t index);
+
+    public:
+        float deadline; // Frame budget in milliseconds
+
+        uint32_t missedDeadlines;
+
+        bool dumpOnHitch;
+
+        uint32_t allocatingFrames; // Steady-state frames that touched the heap
+
+        bool idle; // The host slept on input before this frame, so a long interval isn't a missed deadline
+
+        float cpuUsage; // Process CPU time over wall time for the last second, 1 is one full core
+
+    public:
+        Profiler(float deadline);
+        ~Profiler();
+
+        void beginFrame();
+
+        void endPhase(Phase phase);
+
+        void endFrame();
+
+        uint32_t getFrameCount() const;
+
+        const Frame& getFrame(uint32_t age) const; // 0 is the most recent frame
+
+        void getLows(float& onePercent, float& pointOnePercent);
+
+        bool dump(const char* path) const;
+};
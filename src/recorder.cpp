@@ -0,0 +1,369 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "recorder.h"
+#include <chrono>
+#include <cstring>
+
+#include "logger.h"
+
+Recorder::Recorder() : head(0), tail(0), running(false), file(nullptr), statesFile(nullptr), indexedRecords(0), recording(false), recordCount(0)
+{
+}
+
+Recorder::~Recorder()
+{
+    this->stop();
+}
+
+bool Recorder::start(const char* path)
+{
+    this->stop();
+
+    this->file = std::fopen(path, "wb");
+
+    if(this->file == nullptr)
+    {
+        Logger::log(Logger::Level::Error, "Couldn't open trace file: {s}", path);
+
+        return false;
+    }
+
+    this->statesFile = std::fopen((std::string(path) + ".states").c_str(), "wb");
+
+    this->indexPath = std::string(path) + ".idx";
+
+    this->indexedRecords = 0;
+    this->lastWriters.fill(-1);
+    this->indexBlocks.clear();
+    this->indexFrames.clear();
+    this->postings.assign(Recorder::postingListCount, {});
+
+    const FileHeader header {{'C', '8', 'T', 'R'}, Recorder::version, sizeof(Record), Recorder::blockRecords};
+
+    std::fwrite(&header, sizeof(header), 1, this->file);
+
+    if(this->ring == nullptr)
+        this->ring = std::make_unique<Record[]>(Recorder::ringSize);
+
+    this->head.store(0);
+    this->tail.store(0);
+    this->recordCount = 0;
+
+    this->running.store(true);
+    this->writer = std::thread(&Recorder::writeBlocks, this);
+
+    this->recording = true;
+
+    return true;
+}
+
+void Recorder::stop()
+{
+    if(!this->recording)
+        return;
+
+    this->recording = false;
+
+    this->running.store(false);
+    this->writer.join();
+
+    std::fclose(this->file);
+    this->file = nullptr;
+
+    if(this->statesFile != nullptr)
+        std::fclose(this->statesFile);
+
+    this->statesFile = nullptr;
+
+    if(!this->writeIndex())
+        Logger::log(Logger::Level::Error, "Couldn't write trace index: {s}", this->indexPath.c_str());
+}
+
+void Recorder::recordState(uint32_t frame, const void* state, uint32_t size)
+{
+    if(this->statesFile == nullptr)
+        return;
+
+    const StateHeader header {frame, size};
+
+    std::fwrite(&header, sizeof(header), 1, this->statesFile);
+    std::fwrite(state, 1, size, this->statesFile);
+}
+
+uint32_t Recorder::getWrittenMask(const Record& record)
+{
+    if(record.flags & Recorder::flagMarker)
+        return 0;
+
+    const uint32_t x = 1 << ((record.word >> 8) & 0xF);
+    const uint32_t vf = 1 << 0xF;
+    const uint32_t i = 1 << 16;
+
+    switch(record.opcode)
+    {
+        case Opcode::O6XNN:
+        case Opcode::O7XNN:
+        case Opcode::O8XY0:
+        case Opcode::O8XY1:
+        case Opcode::O8XY2:
+        case Opcode::O8XY3:
+        case Opcode::OCXNN:
+        case Opcode::OFX07:
+            return x;
+
+        case Opcode::OFX0A:
+            return record.flags & Recorder::flagKeyLoaded ? x : 0; // A waiting FX0A writes nothing
+
+        case Opcode::O8XY4:
+        case Opcode::O8XY5:
+        case Opcode::O8XY6:
+        case Opcode::O8XY7:
+        case Opcode::O8XYE:
+            return x | vf;
+
+        case Opcode::ODXYN:
+            return vf;
+
+        case Opcode::OFX65:
+            return (x << 1) - 1;
+
+        case Opcode::OANNN:
+        case Opcode::OFX1E:
+        case Opcode::OFX29:
+            return i;
+
+        default:
+            return 0;
+    }
+}
+
+void Recorder::indexBlock(const Record* records, uint32_t count, uint64_t fileOffset)
+{
+    const uint32_t block = this->indexBlocks.size();
+
+    this->indexBlocks.push_back({fileOffset, this->indexedRecords, this->lastWriters});
+
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        const Record& record = records[i];
+
+        const uint64_t index = this->indexedRecords + i;
+
+        if(record.flags & Recorder::flagFrameStart)
+        {
+            this->indexFrames.push_back({index, record.frame, record.word, static_cast<uint8_t>(record.i), record.value});
+            continue;
+        }
+
+        if(record.flags & Recorder::flagKeyEvent)
+            continue;
+
+        std::vector<uint32_t>& posting = this->postings[record.pc & 0xFFF];
+
+        if(posting.empty() || posting.back() != block)
+            posting.push_back(block);
+
+        uint32_t written = Recorder::getWrittenMask(record);
+
+        for(uint8_t writer = 0; written != 0; ++writer, written >>= 1)
+        {
+            if(written & 1)
+                this->lastWriters[writer] = index;
+        }
+    }
+
+    this->indexedRecords += count;
+}
+
+bool Recorder::writeIndex()
+{
+    std::FILE* index = std::fopen(this->indexPath.c_str(), "wb");
+
+    if(index == nullptr)
+        return false;
+
+    IndexHeader header {{'C', '8', 'T', 'I'}, Recorder::version, this->indexedRecords, static_cast<uint32_t>(this->indexBlocks.size()), static_cast<uint32_t>(this->indexFrames.size()), 0, 0};
+
+    std::vector<IndexPostings> directory(Recorder::postingListCount);
+
+    for(uint16_t pc = 0; pc < Recorder::postingListCount; ++pc)
+    {
+        directory[pc] = {header.postingCount, static_cast<uint32_t>(this->postings[pc].size())};
+
+        header.postingCount += this->postings[pc].size();
+    }
+
+    std::fwrite(&header, sizeof(header), 1, index);
+    std::fwrite(this->indexBlocks.data(), sizeof(IndexBlock), this->indexBlocks.size(), index);
+    std::fwrite(this->indexFrames.data(), sizeof(IndexFrame), this->indexFrames.size(), index);
+    std::fwrite(directory.data(), sizeof(IndexPostings), directory.size(), index);
+
+    for(const auto& posting : this->postings)
+        std::fwrite(posting.data(), sizeof(uint32_t), posting.size(), index);
+
+    return std::fclose(index) == 0;
+}
+
+void Recorder::writeBlocks()
+{
+    std::vector<Record> block(Recorder::blockRecords);
+    std::vector<uint8_t> compressed;
+
+    while(true)
+    {
+        const bool running = this->running.load(std::memory_order_acquire);
+
+        uint64_t tail = this->tail.load(std::memory_order_relaxed);
+        const uint64_t available = this->head.load(std::memory_order_acquire) - tail;
+
+        // Partial blocks are only written when recording stops
+        if(available < Recorder::blockRecords && running)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        if(available == 0)
+            break;
+
+        const uint32_t count = available < Recorder::blockRecords ? available : Recorder::blockRecords;
+
+        for(uint32_t i = 0; i < count; ++i)
+            block[i] = this->ring[(tail + i) & (Recorder::ringSize - 1)];
+
+        this->tail.store(tail + count, std::memory_order_release);
+
+        Recorder::compressBlock(block.data(), count, compressed);
+
+        this->indexBlock(block.data(), count, std::ftell(this->file));
+
+        const BlockHeader header {count, static_cast<uint32_t>(compressed.size())};
+
+        std::fwrite(&header, sizeof(header), 1, this->file);
+        std::fwrite(compressed.data(), 1, compressed.size(), this->file);
+    }
+}
+
+// Blocks are stored column by column, each byte XORed with the same byte of the previous record.
+// Consecutive records mostly share their frame, I and high bytes, so the result is dominated by
+// zero runs. Control bytes below 0x80 are followed by that many plus one literal bytes, control
+// bytes from 0x80 stand for (control & 0x7F) + 1 zero bytes.
+void Recorder::compressBlock(const Record* records, uint32_t count, std::vector<uint8_t>& output)
+{
+    output.clear();
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(records);
+
+    for(uint8_t column = 0; column < sizeof(Record); ++column)
+    {
+        uint8_t previous = 0;
+
+        uint32_t row = 0;
+
+        while(row < count)
+        {
+            uint8_t delta = bytes[row * sizeof(Record) + column] ^ previous;
+
+            if(delta == 0)
+            {
+                uint32_t run = 0;
+
+                while(row < count && run < 128 && (bytes[row * sizeof(Record) + column] ^ previous) == 0)
+                {
+                    ++run;
+                    ++row;
+                }
+
+                output.push_back(0x80 | (run - 1));
+
+                continue;
+            }
+
+            const size_t control = output.size();
+
+            output.push_back(0);
+
+            uint32_t literals = 0;
+
+            while(row < count && literals < 128)
+            {
+                const uint8_t value = bytes[row * sizeof(Record) + column];
+
+                delta = value ^ previous;
+
+                if(delta == 0)
+                    break;
+
+                output.push_back(delta);
+
+                previous = value;
+
+                ++literals;
+                ++row;
+            }
+
+            output[control] = literals - 1;
+        }
+    }
+}
+
+bool Recorder::decompressBlock(const uint8_t* data, size_t size, Record* records, uint32_t count)
+{
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(records);
+
+    size_t position = 0;
+
+    for(uint8_t column = 0; column < sizeof(Record); ++column)
+    {
+        uint8_t previous = 0;
+
+        uint32_t row = 0;
+
+        while(row < count)
+        {
+            if(position >= size)
+                return false;
+
+            const uint8_t control = data[position++];
+
+            const uint32_t length = (control & 0x7F) + 1;
+
+            if(row + length > count)
+                return false;
+
+            if(control & 0x80)
+            {
+                for(uint32_t i = 0; i < length; ++i)
+                    bytes[(row++) * sizeof(Record) + column] = previous;
+
+                continue;
+            }
+
+            if(position + length > size)
+                return false;
+
+            for(uint32_t i = 0; i < length; ++i)
+            {
+                previous ^= data[position++];
+
+                bytes[(row++) * sizeof(Record) + column] = previous;
+            }
+        }
+    }
+
+    return position == size;
+}
@@ -0,0 +1,247 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "opcode.h"
+
+// Records every executed instruction into a ring drained by a background thread, which
+// compresses blocks of records into a trace file. See tools/tracedump.cpp for the reader.
+
+class Recorder
+{
+    public:
+        struct Record
+        {
+            uint16_t pc; // Address the instruction was fetched from
+            uint16_t word;
+            uint16_t i; // Index register after the instruction
+
+            Opcode opcode;
+
+            uint8_t reg; // First register the instruction changed, Recorder::noRegister if none
+            uint8_t value; // New value of that register
+            uint8_t vf; // VF after the instruction
+
+            uint8_t flags;
+
+            uint8_t padding;
+
+            uint32_t frame;
+        };
+
+        static_assert(sizeof(Record) == 16, "Trace records are fixed width");
+
+        static constexpr uint8_t noRegister = 0xFF;
+
+        static constexpr uint8_t flagIChanged = 1 << 0;
+        static constexpr uint8_t flagVFChanged = 1 << 1;
+        static constexpr uint8_t flagMultipleRegisters = 1 << 2; // LD_VX_MI and friends changed more than one register
+        static constexpr uint8_t flagFrameStart = 1 << 3; // Marker record, word holds the keypad mask, i the instructions per frame and value the key events after it
+        static constexpr uint8_t flagKeyEvent = 1 << 4; // Marker record following its frame's, word holds the new keypad mask and i the instruction it applies at
+        static constexpr uint8_t flagMarker = Recorder::flagFrameStart | Recorder::flagKeyEvent; // Records that aren't instructions
+        static constexpr uint8_t flagKeyLoaded = 1 << 5; // FX0A found a key release and wrote it to VX, even if VX kept its value
+
+        static constexpr uint8_t writerCount = 17; // V0 to VF, then I
+
+        struct FileHeader
+        {
+            char magic[4]; // "C8TR"
+
+            uint32_t version;
+            uint32_t recordSize;
+            uint32_t blockRecords;
+        };
+
+        struct BlockHeader
+        {
+            uint32_t recordCount;
+            uint32_t compressedSize;
+        };
+
+        // Written next to the trace as <trace>.idx once recording stops
+        struct IndexHeader
+        {
+            char magic[4]; // "C8TI"
+
+            uint32_t version;
+
+            uint64_t recordCount;
+
+            uint32_t blockCount;
+            uint32_t frameCount;
+
+            uint32_t postingCount; // Total entries in all posting lists
+
+            uint32_t padding;
+        };
+
+        struct IndexBlock
+        {
+            uint64_t fileOffset; // Offset of the block header in the trace
+            uint64_t firstRecord;
+
+            std::array<int64_t, Recorder::writerCount> lastWriters; // Last record to write each register before the block, -1 if none
+        };
+
+        struct IndexFrame
+        {
+            uint64_t firstRecord; // The frame's marker record
+
+            uint32_t frame;
+
+            uint16_t keys;
+
+            uint8_t instructions;
+
+            uint8_t events; // Key event records following the frame's
+        };
+
+        struct IndexPostings
+        {
+            uint32_t offset; // Into the posting entries
+            uint32_t count;
+        };
+
+        // An index file is IndexHeader, blockCount IndexBlocks, frameCount IndexFrames,
+        // Recorder::postingListCount IndexPostings and postingCount uint32_t block numbers.
+        static constexpr uint16_t postingListCount = 4096; // One per address, listing the blocks that executed it
+
+        static constexpr uint32_t version = 4;
+
+        static constexpr uint32_t stateInterval = 60; // Frames between savestates in <trace>.states
+
+        static constexpr uint32_t blockRecords = 4096; // Records compressed together
+        static constexpr uint32_t ringSize = 1 << 20; // Records buffered between the threads, must be a power of two
+
+        // Appended to <trace>.states by the emulation thread
+        struct StateHeader
+        {
+            uint32_t frame;
+            uint32_t size;
+        };
+
+    private:
+        std::unique_ptr<Record[]> ring;
+
+        std::atomic<uint64_t> head; // Written by the emulation thread
+        std::atomic<uint64_t> tail; // Written by the writer thread
+
+        std::atomic<bool> running;
+
+        std::FILE* file;
+
+        std::FILE* statesFile;
+
+        std::string indexPath;
+
+        // Index under construction, only touched by the writer thread
+        uint64_t indexedRecords;
+
+        std::array<int64_t, Recorder::writerCount> lastWriters;
+
+        std::vector<IndexBlock> indexBlocks;
+        std::vector<IndexFrame> indexFrames;
+        std::vector<std::vector<uint32_t>> postings;
+
+        std::thread writer;
+
+        bool recording; // Plain flag checked once per instruction by the emulation thread
+
+    private:
+        void writeBlocks();
+
+        void indexBlock(const Record* records, uint32_t count, uint64_t fileOffset);
+
+        bool writeIndex();
+
+    public:
+        uint64_t recordCount; // Records written since start()
+
+    public:
+        Recorder();
+        ~Recorder();
+
+        bool start(const char* path);
+
+        void stop();
+
+        bool isRecording() const
+        {
+            return this->recording;
+        }
+
+        void record(const Record& record)
+        {
+            const uint64_t head = this->head.load(std::memory_order_relaxed);
+
+            // Wait for the writer rather than lose history, a divergence could be in any record
+            while(head - this->tail.load(std::memory_order_acquire) >= Recorder::ringSize)
+                std::this_thread::yield();
+
+            this->ring[head & (Recorder::ringSize - 1)] = record;
+
+            this->head.store(head + 1, std::memory_order_release);
+
+            ++this->recordCount;
+        }
+
+        void recordFrame(uint32_t frame, uint16_t keys, uint8_t instructions, uint8_t events)
+        {
+            Record marker {};
+
+            marker.word = keys;
+            marker.i = instructions;
+            marker.opcode = Opcode::Invalid;
+            marker.reg = Recorder::noRegister;
+            marker.value = events;
+            marker.flags = Recorder::flagFrameStart;
+            marker.frame = frame;
+
+            this->record(marker);
+        }
+
+        void recordKeyEvent(uint32_t frame, uint16_t keys, uint8_t instruction)
+        {
+            Record marker {};
+
+            marker.word = keys;
+            marker.i = instruction;
+            marker.opcode = Opcode::Invalid;
+            marker.reg = Recorder::noRegister;
+            marker.flags = Recorder::flagKeyEvent;
+            marker.frame = frame;
+
+            this->record(marker);
+        }
+
+        void recordState(uint32_t frame, const void* state, uint32_t size);
+
+        static uint32_t getWrittenMask(const Record& record); // Bit n for Vn, bit 16 for I
+
+        static void compressBlock(const Record* records, uint32_t count, std::vector<uint8_t>& output);
+
+        static bool decompressBlock(const uint8_t* data, size_t size, Record* records, uint32_t count);
+};
@@ -0,0 +1,143 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "corpus.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+Corpus::MappedFile::MappedFile(const std::filesystem::path& path) : data(nullptr), size(0)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY);
+
+    if(fd == -1)
+        return;
+
+    struct stat info;
+
+    void* mapping = MAP_FAILED;
+
+    if(fstat(fd, &info) == 0 && info.st_size > 0)
+        mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    ::close(fd);
+
+    if(mapping == MAP_FAILED)
+        return;
+
+    this->data = static_cast<const uint8_t*>(mapping);
+    this->size = info.st_size;
+}
+
+Corpus::MappedFile::~MappedFile()
+{
+    if(this->data != nullptr)
+        munmap(const_cast<uint8_t*>(this->data), this->size);
+}
+
+bool Corpus::MappedFile::isOpen() const
+{
+    return this->data != nullptr;
+}
+
+const uint8_t* Corpus::MappedFile::getData() const
+{
+    return this->data;
+}
+
+size_t Corpus::MappedFile::getSize() const
+{
+    return this->size;
+}
+
+bool Corpus::isROM(const std::filesystem::path& path)
+{
+    std::string extension = path.extension().string();
+
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+
+    return extension == ".ch8" || extension == ".c8" || extension == ".sc8" || extension == ".xo8";
+}
+
+std::vector<Corpus::ROM> Corpus::collect(const std::vector<std::string>& paths)
+{
+    std::vector<ROM> roms;
+
+    for(const std::string& argument : paths)
+    {
+        const std::filesystem::path path(argument);
+
+        std::error_code error;
+
+        if(!std::filesystem::is_directory(path, error))
+        {
+            roms.push_back({path, argument});
+            continue;
+        }
+
+        std::vector<ROM> found;
+
+        for(const auto& entry : std::filesystem::recursive_directory_iterator(path, std::filesystem::directory_options::skip_permission_denied, error))
+        {
+            if(entry.is_regular_file(error) && Corpus::isROM(entry.path()))
+                found.push_back({entry.path(), std::filesystem::relative(entry.path(), path, error).string()});
+        }
+
+        if(error)
+            std::fprintf(stderr, "Couldn't read all of %s: %s\n", argument.c_str(), error.message().c_str());
+
+        // Directory iteration order is unspecified
+        std::sort(found.begin(), found.end(), [](const ROM& a, const ROM& b) { return a.name < b.name; });
+
+        roms.insert(roms.end(), found.begin(), found.end());
+    }
+
+    return roms;
+}
+
+void Corpus::parallelFor(size_t count, unsigned threads, const std::function<void(size_t)>& work)
+{
+    if(threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    threads = static_cast<unsigned>(std::min<size_t>(threads, count));
+
+    std::atomic<size_t> next(0);
+
+    auto worker = [&]
+    {
+        for(size_t i = next++; i < count; i = next++)
+            work(i);
+    };
+
+    std::vector<std::thread> workers;
+
+    // The calling thread works too
+    for(unsigned i = 1; i < threads; ++i)
+        workers.emplace_back(worker);
+
+    worker();
+
+    for(std::thread& thread : workers)
+        thread.join();
+}
@@ -0,0 +1,65 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+// Helpers shared by the command line tools that work over whole ROM archives.
+
+#include <stdint.h>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Corpus
+{
+    struct ROM
+    {
+        std::filesystem::path path;
+
+        std::string name; // Path relative to the directory it was found in, or the path as given
+    };
+
+    // A read-only memory mapping of a whole file
+    class MappedFile
+    {
+        private:
+            const uint8_t* data;
+            size_t size;
+
+        public:
+            MappedFile(const std::filesystem::path& path);
+            ~MappedFile();
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            bool isOpen() const;
+
+            const uint8_t* getData() const;
+
+            size_t getSize() const;
+    };
+
+    bool isROM(const std::filesystem::path& path); // By extension, for directory mode
+
+    // Expands files and directories (recursively) into a list sorted by name so output order is stable
+    std::vector<ROM> collect(const std::vector<std::string>& paths);
+
+    // Runs work(i) for every i in [0, count) on up to threads threads, 0 meaning one per core
+    void parallelFor(size_t count, unsigned threads, const std::function<void(size_t)>& work);
+}
@@ -0,0 +1,260 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Disassembles ROMs in parallel, one listing per ROM or one combined listing in a stable order.
+// Usage: chip8-disasm [-a] [-j threads] [-o directory] <rom|directory>...
+//   -a  Analyse control flow and list unreached bytes as data instead of decoding every word
+
+#include <stdint.h>
+#include <cstdio>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "corpus.h"
+#include "../analysis.h"
+#include "../disassembler.h"
+
+namespace
+{
+    constexpr size_t chunkSize = 256; // ROMs formatted before the combined listing is written out
+
+    bool analyse = false;
+
+    // Instructions where the analysis reached code, runs of data bytes everywhere else
+    size_t formatAnalysed(const uint8_t* data, size_t size, std::string& listing)
+    {
+        const std::shared_ptr<const Analysis> analysis = Analysis::get(data, size);
+
+        // Worst case is one data byte per line between instructions
+        listing.resize(size * Disassembler::maxLineLength);
+
+        size_t written = 0;
+
+        for(size_t offset = 0; offset < size;)
+        {
+            const uint16_t address = CPU::pcStart + offset;
+
+            if(offset + 1 < size && analysis->isCode(address))
+            {
+                Instruction instruction(data[offset] << 8 | data[offset + 1]);
+
+                instruction.opcode = Parser::parse(instruction);
+
+                written += Disassembler::disassembleInstruction(&listing[written], Disassembler::maxLineLength, address, instruction);
+
+                listing[written++] = '\n';
+
+                offset += 2;
+                continue;
+            }
+
+            // Up to a line of bytes, stopping at the next instruction
+            size_t count = 1;
+
+            while(count < Disassembler::dataBytesPerLine && offset + count < size && !analysis->isCode(address + count))
+                ++count;
+
+            written += Disassembler::disassembleData(&listing[written], Disassembler::maxDataLineLength, address, data + offset, count);
+
+            listing[written++] = '\n';
+
+            offset += count;
+        }
+
+        return written;
+    }
+
+    // Formats a whole ROM straight from the mapping, without copying it into emulated memory
+    bool disassembleROM(const Corpus::ROM& rom, std::string& listing)
+    {
+        const Corpus::MappedFile file(rom.path);
+
+        if(!file.isOpen())
+        {
+            std::fprintf(stderr, "Couldn't open ROM: %s\n", rom.path.c_str());
+            return false;
+        }
+
+        const uint8_t* data = file.getData();
+        const size_t size = file.getSize();
+
+        // Same limit as Memory::loadROM, anything past it would wrap around the address space
+        if(size > Memory::memorySize - CPU::pcStart)
+        {
+            std::fprintf(stderr, "ROM too large: %s\n", rom.path.c_str());
+            return false;
+        }
+
+        if(analyse)
+        {
+            listing.resize(formatAnalysed(data, size, listing));
+            return true;
+        }
+
+        listing.resize(((size + 1) / 2) * Disassembler::maxLineLength);
+
+        size_t written = 0;
+
+        for(size_t offset = 0; offset < size; offset += 2)
+        {
+            // An odd final byte is read as if followed by zeroed memory, like the emulator would
+            const uint16_t word = data[offset] << 8 | (offset + 1 < size ? data[offset + 1] : 0);
+
+            Instruction instruction(word);
+
+            instruction.opcode = Parser::parse(instruction);
+
+            written += Disassembler::disassembleInstruction(&listing[written], Disassembler::maxLineLength, CPU::pcStart + offset, instruction);
+
+            listing[written++] = '\n';
+        }
+
+        listing.resize(written);
+
+        return true;
+    }
+
+    // Where a ROM's listing goes under the output directory, empty when its name would land outside it
+    std::filesystem::path getOutputPath(const std::filesystem::path& directory, const Corpus::ROM& rom)
+    {
+        // Files given directly are named as typed, which may be absolute or climb out with ..
+        const std::filesystem::path name = rom.name == rom.path.string() ? rom.path.filename() : std::filesystem::path(rom.name);
+
+        const std::filesystem::path root = directory.lexically_normal();
+        const std::filesystem::path output = (root / (name.string() + ".txt")).lexically_normal();
+
+        const std::filesystem::path relative = output.lexically_relative(root);
+
+        if(name.is_absolute() || relative.empty() || *relative.begin() == "..")
+            return {};
+
+        return output;
+    }
+
+    bool writeFile(const std::filesystem::path& path, const std::string& contents)
+    {
+        std::error_code error;
+
+        std::filesystem::create_directories(path.parent_path(), error);
+
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+
+        if(file == nullptr)
+            return false;
+
+        const bool written = std::fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+
+        return std::fclose(file) == 0 && written;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned threads = 0;
+
+    const char* outputDirectory = nullptr;
+
+    std::vector<std::string> paths;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        if(std::strcmp(argv[i], "-a") == 0)
+            analyse = true;
+        else if(std::strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            threads = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            outputDirectory = argv[++i];
+        else
+            paths.push_back(argv[i]);
+    }
+
+    if(paths.empty())
+    {
+        std::fprintf(stderr, "Usage: %s [-a] [-j threads] [-o directory] <rom|directory>...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<Corpus::ROM> roms = Corpus::collect(paths);
+
+    std::atomic<bool> failed(false);
+
+    // Per-ROM listings are written by the workers themselves
+    if(outputDirectory != nullptr)
+    {
+        Corpus::parallelFor(roms.size(), threads, [&](size_t i)
+        {
+            std::string listing;
+
+            if(!disassembleROM(roms[i], listing))
+            {
+                failed = true;
+                return;
+            }
+
+            const std::filesystem::path output = getOutputPath(outputDirectory, roms[i]);
+
+            if(output.empty())
+            {
+                std::fprintf(stderr, "Listing would be written outside %s: %s\n", outputDirectory, roms[i].name.c_str());
+                failed = true;
+                return;
+            }
+
+            if(!writeFile(output, listing))
+            {
+                std::fprintf(stderr, "Couldn't write listing: %s\n", output.c_str());
+                failed = true;
+            }
+        });
+
+        return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    // The combined listing is formatted a chunk at a time in parallel and written in input order
+    std::vector<std::string> listings(chunkSize);
+    std::vector<char> ok(chunkSize);
+
+    for(size_t start = 0; start < roms.size(); start += chunkSize)
+    {
+        const size_t count = std::min(chunkSize, roms.size() - start);
+
+        Corpus::parallelFor(count, threads, [&](size_t i)
+        {
+            ok[i] = disassembleROM(roms[start + i], listings[i]);
+        });
+
+        for(size_t i = 0; i < count; ++i)
+        {
+            if(!ok[i])
+            {
+                failed = true;
+                continue;
+            }
+
+            std::printf("; %s\n", roms[start + i].name.c_str());
+
+            std::fwrite(listings[i].data(), 1, listings[i].size(), stdout);
+
+            std::printf("\n");
+        }
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,104 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Measures disassembler throughput in lines per second for the string and buffer APIs.
+// Usage: chip8-disasm-bench [rom]
+
+#include <stdint.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "../disassembler.h"
+
+namespace
+{
+    constexpr double benchmarkSeconds = 1.0;
+
+    template<typename Function>
+    double linesPerSecond(Function disassembleProgram, uint32_t linesPerRun)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        uint64_t lines = 0;
+        double elapsed = 0.0;
+
+        while(elapsed < benchmarkSeconds)
+        {
+            disassembleProgram();
+
+            lines += linesPerRun;
+
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        return lines / elapsed;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Memory memory;
+
+    if(argc > 1)
+    {
+        memory.loadROM(argv[1]);
+
+        if(!memory.romLoaded)
+            return EXIT_FAILURE;
+    }
+    else
+    {
+        // Without a ROM, fill the program area with a fixed mix of every opcode
+        uint32_t state = 0x12345678;
+
+        for(uint16_t address = CPU::pcStart; address < Memory::memorySize; ++address)
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+
+            memory[address] = state >> 24;
+        }
+
+        memory.romSize = Memory::memorySize - CPU::pcStart;
+    }
+
+    const uint16_t end = CPU::pcStart + memory.romSize;
+    const uint32_t lineCount = (memory.romSize + 1) / 2;
+
+    static char buffer[(Memory::memorySize / 2) * (Disassembler::maxLineLength + 1) + 1];
+
+    volatile size_t sink = 0; // Keeps the work from being optimised away
+
+    const double stringRate = linesPerSecond([&]
+    {
+        Disassembler disassembler;
+
+        sink = sink + disassembler.disassemble(memory).size();
+    }, lineCount);
+
+    const double bufferRate = linesPerSecond([&]
+    {
+        sink = sink + Disassembler::disassembleRange(buffer, sizeof(buffer), memory, CPU::pcStart, end);
+    }, lineCount);
+
+    std::printf("%u lines per run\n", lineCount);
+    std::printf("std::string API: %12.0f lines/s\n", stringRate);
+    std::printf("buffer API:      %12.0f lines/s (%.1fx)\n", bufferRate, bufferRate / stringRate);
+
+    return EXIT_SUCCESS;
+}
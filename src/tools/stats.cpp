@@ -0,0 +1,417 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Runs every ROM headlessly and reports opcode, sequence, sprite and loop statistics for the corpus.
+// Usage: chip8-stats [-n frames] [-i instructions per frame] [-j threads] [--csv] <rom|directory>...
+//   JSON (the default) has the corpus totals and a row per ROM, CSV has only the rows per ROM.
+
+#include <stdint.h>
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "corpus.h"
+#include "../chip8.h"
+
+namespace
+{
+    constexpr size_t opcodeCount = static_cast<size_t>(Opcode::Invalid) + 1;
+
+    constexpr std::array<const char*, opcodeCount> opcodeNames
+    {
+        "00E0", "00EE", "1NNN", "2NNN", "3XNN", "4XNN", "5XY0", "6XNN", "7XNN", "8XY0", "8XY1", "8XY2",
+        "8XY3", "8XY4", "8XY5", "8XY6", "8XY7", "8XYE", "9XY0", "ANNN", "BNNN", "CXNN", "DXYN", "EX9E",
+        "EXA1", "FX07", "FX0A", "FX15", "FX18", "FX1E", "FX29", "FX33", "FX55", "FX65", "Invalid",
+    };
+
+    constexpr uint8_t pollingLoopLength = 4; // Longest DT polling loop recognised, in instructions
+
+    constexpr size_t topSequences = 20;
+
+    struct Stats
+    {
+        std::array<uint64_t, opcodeCount> opcodes {};
+
+        std::array<uint64_t, 16> spriteHeights {}; // DRW rows, 0 meaning 16 on SCHIP
+
+        std::unordered_map<uint32_t, uint64_t> bigrams; // Opcodes packed a byte each
+        std::unordered_map<uint32_t, uint64_t> trigrams;
+
+        uint64_t instructions = 0;
+        uint64_t pollingInstructions = 0; // Spent in short loops that read DT and jump back
+        uint64_t selfModifiedInstructions = 0; // Fetched from bytes the program wrote itself
+
+        const char* stopped = nullptr; // Why the run ended early, if it did
+    };
+
+    uint32_t frames = 600;
+    uint8_t instructionsPerFrame = 11;
+
+    void runFrames(Chip8& chip8, Stats& stats)
+    {
+        std::bitset<Memory::memorySize> written;
+
+        uint32_t history = 0; // Last three opcodes, newest in the low byte
+        uint8_t historyLength = 0;
+
+        uint64_t lastTimerRead = UINT64_MAX; // Instruction count of the last FX07
+
+        for(uint32_t frame = 0; frame < frames && stats.stopped == nullptr; ++frame)
+        {
+            chip8.beginFrame(0);
+
+            while(chip8.frameInstruction < chip8.instructionsPerSecond)
+            {
+                const uint16_t pc = chip8.cpu.pc;
+
+                Instruction instruction(chip8.memory.peekWord(pc));
+
+                instruction.opcode = Parser::parse(instruction);
+
+                // The core exits on invalid opcodes, so stop this ROM before it gets there
+                if(instruction.opcode == Opcode::Invalid)
+                {
+                    stats.stopped = "invalid opcode";
+                    break;
+                }
+
+                const size_t opcode = static_cast<size_t>(instruction.opcode);
+
+                ++stats.opcodes[opcode];
+                ++stats.instructions;
+
+                history = (history << 8 | opcode) & 0xFFFFFF;
+                historyLength = std::min<uint8_t>(historyLength + 1, 3);
+
+                if(historyLength >= 2)
+                    ++stats.bigrams[history & 0xFFFF];
+
+                if(historyLength >= 3)
+                    ++stats.trigrams[history];
+
+                if(written[pc & 0xFFF] || written[(pc + 1) & 0xFFF])
+                    ++stats.selfModifiedInstructions;
+
+                switch(instruction.opcode)
+                {
+                    case Opcode::ODXYN:
+                        ++stats.spriteHeights[instruction.getN()];
+                        break;
+
+                    case Opcode::OFX07:
+                        lastTimerRead = chip8.instructionCount;
+                        break;
+
+                    case Opcode::O1NNN:
+                    {
+                        // A short backward jump shortly after reading DT closes a polling loop iteration
+                        const uint16_t target = instruction.getNNN();
+                        const uint64_t sinceRead = chip8.instructionCount - lastTimerRead;
+
+                        if(lastTimerRead != UINT64_MAX && target <= pc && pc - target < pollingLoopLength * 2 && sinceRead < pollingLoopLength)
+                            stats.pollingInstructions += (pc - target) / 2 + 1;
+
+                        break;
+                    }
+
+                    case Opcode::OFX33:
+                        for(uint16_t i = 0; i < 3; ++i)
+                            written[(chip8.cpu.i + i) & 0xFFF] = true;
+                        break;
+
+                    case Opcode::OFX55:
+                        for(uint16_t i = 0; i <= instruction.getX(); ++i)
+                            written[(chip8.cpu.i + i) & 0xFFF] = true;
+                        break;
+
+                    default:
+                        break;
+                }
+
+                chip8.step();
+            }
+
+            chip8.endFrame();
+        }
+    }
+
+    void run(const Corpus::ROM& rom, Stats& stats)
+    {
+        static thread_local Chip8 chip8;
+
+        chip8.reset(true);
+        chip8.memory.loadROM(rom.path.c_str());
+
+        if(!chip8.memory.romLoaded)
+            return;
+
+        chip8.instructionsPerSecond = instructionsPerFrame;
+        chip8.frameInstruction = 0; // A fault in the previous ROM can leave a frame open
+
+        // A fixed seed per ROM keeps runs reproducible whatever the thread scheduling
+        chip8.cpu.rngState = static_cast<uint32_t>(chip8.memory.romHash) | 1;
+
+        // Broken programs make the core throw on stack and memory bounds, which ends just that ROM
+        try
+        {
+            runFrames(chip8, stats);
+        }
+        catch(const std::exception&)
+        {
+            stats.stopped = "fault";
+        }
+    }
+
+    std::string sequenceName(uint32_t packed, uint8_t length, char separator)
+    {
+        std::string name;
+
+        for(int i = length - 1; i >= 0; --i)
+        {
+            name += opcodeNames[(packed >> (i * 8)) & 0xFF];
+
+            if(i > 0)
+                name += separator;
+        }
+
+        return name;
+    }
+
+    std::vector<std::pair<uint32_t, uint64_t>> mostCommon(const std::unordered_map<uint32_t, uint64_t>& counts)
+    {
+        std::vector<std::pair<uint32_t, uint64_t>> sorted(counts.begin(), counts.end());
+
+        // Ties broken by sequence so the output doesn't depend on hash order
+        std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.second != b.second ? a.second > b.second : a.first < b.first; });
+
+        if(sorted.size() > topSequences)
+            sorted.resize(topSequences);
+
+        return sorted;
+    }
+
+    double fraction(uint64_t part, uint64_t whole)
+    {
+        return whole == 0 ? 0.0 : static_cast<double>(part) / whole;
+    }
+
+    std::string jsonString(const std::string& text)
+    {
+        std::string quoted = "\"";
+
+        for(const char c : text)
+        {
+            if(c == '"' || c == '\\')
+            {
+                quoted += '\\';
+                quoted += c;
+            }
+            else if(c == '\n')
+                quoted += "\\n";
+            else if(c == '\t')
+                quoted += "\\t";
+            else if(static_cast<unsigned char>(c) < 0x20)
+            {
+                // The other control characters have no short escape in JSON
+                char escaped[7];
+
+                std::snprintf(escaped, sizeof(escaped), "\\u%04X", static_cast<unsigned char>(c));
+
+                quoted += escaped;
+            }
+            else
+                quoted += c;
+        }
+
+        return quoted + "\"";
+    }
+
+    std::string csvString(const std::string& text)
+    {
+        std::string quoted = "\"";
+
+        for(const char c : text)
+        {
+            if(c == '"')
+                quoted += '"';
+
+            quoted += c;
+        }
+
+        return quoted + "\"";
+    }
+
+    void writeCSV(const std::vector<Corpus::ROM>& roms, const std::vector<Stats>& results)
+    {
+        std::printf("rom,instructions,polling_fraction,self_modifying_fraction,stopped");
+
+        for(const char* name : opcodeNames)
+            std::printf(",op_%s", name);
+
+        for(int height = 0; height < 16; ++height)
+            std::printf(",drw_%d", height);
+
+        std::printf("\n");
+
+        for(size_t i = 0; i < roms.size(); ++i)
+        {
+            const Stats& stats = results[i];
+
+            std::printf("%s,%llu,%.6f,%.6f,%s", csvString(roms[i].name).c_str(), static_cast<unsigned long long>(stats.instructions), fraction(stats.pollingInstructions, stats.instructions), fraction(stats.selfModifiedInstructions, stats.instructions), stats.stopped != nullptr ? stats.stopped : "");
+
+            for(const uint64_t count : stats.opcodes)
+                std::printf(",%llu", static_cast<unsigned long long>(count));
+
+            for(const uint64_t count : stats.spriteHeights)
+                std::printf(",%llu", static_cast<unsigned long long>(count));
+
+            std::printf("\n");
+        }
+    }
+
+    void writeSequences(const char* key, const std::unordered_map<uint32_t, uint64_t>& counts, uint8_t length)
+    {
+        std::printf("  \"%s\": [\n", key);
+
+        const auto sorted = mostCommon(counts);
+
+        for(size_t i = 0; i < sorted.size(); ++i)
+            std::printf("    {\"sequence\": \"%s\", \"count\": %llu}%s\n", sequenceName(sorted[i].first, length, ' ').c_str(), static_cast<unsigned long long>(sorted[i].second), i + 1 < sorted.size() ? "," : "");
+
+        std::printf("  ],\n");
+    }
+
+    void writeJSON(const std::vector<Corpus::ROM>& roms, const std::vector<Stats>& results, const Stats& total)
+    {
+        std::printf("{\n");
+        std::printf("  \"roms\": %zu,\n", roms.size());
+        std::printf("  \"frames\": %u,\n", frames);
+        std::printf("  \"instructionsPerFrame\": %u,\n", instructionsPerFrame);
+        std::printf("  \"instructions\": %llu,\n", static_cast<unsigned long long>(total.instructions));
+        std::printf("  \"pollingFraction\": %.6f,\n", fraction(total.pollingInstructions, total.instructions));
+        std::printf("  \"selfModifyingFraction\": %.6f,\n", fraction(total.selfModifiedInstructions, total.instructions));
+
+        std::printf("  \"opcodes\": {");
+
+        for(size_t i = 0; i < opcodeCount; ++i)
+            std::printf("%s\"%s\": %llu", i > 0 ? ", " : "", opcodeNames[i], static_cast<unsigned long long>(total.opcodes[i]));
+
+        std::printf("},\n");
+
+        std::printf("  \"spriteHeights\": [");
+
+        for(size_t i = 0; i < total.spriteHeights.size(); ++i)
+            std::printf("%s%llu", i > 0 ? ", " : "", static_cast<unsigned long long>(total.spriteHeights[i]));
+
+        std::printf("],\n");
+
+        writeSequences("bigrams", total.bigrams, 2);
+        writeSequences("trigrams", total.trigrams, 3);
+
+        std::printf("  \"perROM\": [\n");
+
+        for(size_t i = 0; i < roms.size(); ++i)
+        {
+            const Stats& stats = results[i];
+
+            std::printf("    {\"rom\": %s, \"instructions\": %llu, \"pollingFraction\": %.6f, \"selfModifyingFraction\": %.6f, \"stopped\": %s}%s\n", jsonString(roms[i].name).c_str(), static_cast<unsigned long long>(stats.instructions), fraction(stats.pollingInstructions, stats.instructions), fraction(stats.selfModifiedInstructions, stats.instructions), stats.stopped != nullptr ? jsonString(stats.stopped).c_str() : "null", i + 1 < roms.size() ? "," : "");
+        }
+
+        std::printf("  ]\n");
+        std::printf("}\n");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned threads = 0;
+
+    bool csv = false;
+
+    std::vector<std::string> paths;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        if(std::strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            frames = std::strtoul(argv[++i], nullptr, 10);
+        else if(std::strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+            instructionsPerFrame = std::clamp(std::atoi(argv[++i]), 1, 255);
+        else if(std::strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            threads = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i], "--csv") == 0)
+            csv = true;
+        else
+            paths.push_back(argv[i]);
+    }
+
+    if(paths.empty())
+    {
+        std::fprintf(stderr, "Usage: %s [-n frames] [-i instructions per frame] [-j threads] [--csv] <rom|directory>...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<Corpus::ROM> roms = Corpus::collect(paths);
+
+    std::vector<Stats> results(roms.size());
+
+    Stats total;
+
+    std::mutex totalMutex;
+
+    Corpus::parallelFor(roms.size(), threads, [&](size_t i)
+    {
+        Stats& stats = results[i];
+
+        run(roms[i], stats);
+
+        std::lock_guard<std::mutex> lock(totalMutex);
+
+        for(size_t opcode = 0; opcode < opcodeCount; ++opcode)
+            total.opcodes[opcode] += stats.opcodes[opcode];
+
+        for(size_t height = 0; height < total.spriteHeights.size(); ++height)
+            total.spriteHeights[height] += stats.spriteHeights[height];
+
+        for(const auto& [sequence, count] : stats.bigrams)
+            total.bigrams[sequence] += count;
+
+        for(const auto& [sequence, count] : stats.trigrams)
+            total.trigrams[sequence] += count;
+
+        total.instructions += stats.instructions;
+        total.pollingInstructions += stats.pollingInstructions;
+        total.selfModifiedInstructions += stats.selfModifiedInstructions;
+
+        // The rows only need the totals above, drop the sequence tables early
+        stats.bigrams = {};
+        stats.trigrams = {};
+    });
+
+    if(csv)
+        writeCSV(roms, results);
+    else
+        writeJSON(roms, results, total);
+
+    return EXIT_SUCCESS;
+}
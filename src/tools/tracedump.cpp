@@ -0,0 +1,115 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Decodes an execution trace written by Recorder back to text.
+// Usage: chip8-tracedump <trace.c8t>
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "../disassembler.h"
+#include "../recorder.h"
+
+int main(int argc, char* argv[])
+{
+    if(argc < 2)
+    {
+        std::fprintf(stderr, "Usage: %s <trace.c8t>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::FILE* file = std::fopen(argv[1], "rb");
+
+    if(file == nullptr)
+    {
+        std::fprintf(stderr, "Couldn't open trace: %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    Recorder::FileHeader header;
+
+    if(std::fread(&header, sizeof(header), 1, file) != 1 || header.magic[0] != 'C' || header.magic[1] != '8' || header.magic[2] != 'T' || header.magic[3] != 'R' || header.version != Recorder::version || header.recordSize != sizeof(Recorder::Record))
+    {
+        std::fprintf(stderr, "Not a supported trace: %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    char line[Disassembler::maxLineLength];
+
+    std::vector<Recorder::Record> records(header.blockRecords);
+    std::vector<uint8_t> compressed;
+
+    Recorder::BlockHeader block;
+
+    while(std::fread(&block, sizeof(block), 1, file) == 1)
+    {
+        compressed.resize(block.compressedSize);
+
+        if(block.recordCount > header.blockRecords || std::fread(compressed.data(), 1, compressed.size(), file) != compressed.size() || !Recorder::decompressBlock(compressed.data(), compressed.size(), records.data(), block.recordCount))
+        {
+            std::fprintf(stderr, "Corrupt block in trace: %s\n", argv[1]);
+            return EXIT_FAILURE;
+        }
+
+        for(uint32_t i = 0; i < block.recordCount; ++i)
+        {
+            const Recorder::Record& record = records[i];
+
+            if(record.flags & Recorder::flagFrameStart)
+            {
+                std::printf("%8u ---- frame, keys %04X, %u instructions\n", record.frame, record.word, record.i);
+                continue;
+            }
+
+            if(record.flags & Recorder::flagKeyEvent)
+            {
+                std::printf("%8u ---- keys %04X from instruction %u\n", record.frame, record.word, record.i);
+                continue;
+            }
+
+            Instruction instruction(record.word);
+
+            instruction.opcode = record.opcode;
+
+            Disassembler::disassembleInstruction(line, sizeof(line), record.pc, instruction);
+
+            std::printf("%8u %04X  %-24s", record.frame, record.word, line);
+
+            if(record.reg != Recorder::noRegister)
+                std::printf(" V%X=%02X", record.reg, record.value);
+
+            if(record.flags & Recorder::flagMultipleRegisters)
+                std::printf(" ...");
+
+            if(record.flags & Recorder::flagVFChanged)
+                std::printf(" VF=%02X", record.vf);
+
+            if(record.flags & Recorder::flagIChanged)
+                std::printf(" I=%03X", record.i);
+
+            if(record.flags & Recorder::flagKeyLoaded)
+                std::printf(" key");
+
+            std::printf("\n");
+        }
+    }
+
+    std::fclose(file);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "trace.h"
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    const auto traceStart = std::chrono::steady_clock::now();
+
+    std::mutex buffersMutex; // Guards registration and flushing, never taken while recording
+
+    std::vector<std::unique_ptr<Trace::ThreadBuffer>> buffers; // Outlive their threads so zones survive until flushed
+
+    Trace::ThreadBuffer* registerThread()
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+
+        buffers.push_back(std::make_unique<Trace::ThreadBuffer>());
+
+        Trace::ThreadBuffer* buffer = buffers.back().get();
+
+        buffer->threadID = buffers.size();
+        buffer->count.store(0, std::memory_order_relaxed);
+
+        return buffer;
+    }
+}
+
+Trace::Zone::Zone(const char* name) : name(name), begin(Trace::now())
+{
+}
+
+Trace::Zone::~Zone()
+{
+    Trace::record(this->name, this->begin, Trace::now());
+}
+
+uint64_t Trace::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - traceStart).count();
+}
+
+void Trace::record(const char* name, uint64_t begin, uint64_t end)
+{
+    thread_local ThreadBuffer* buffer = registerThread();
+
+    const uint64_t count = buffer->count.load(std::memory_order_relaxed);
+
+    Slot& slot = buffer->events[count & (Trace::bufferSize - 1)];
+
+    slot.sequence.store(0, std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.begin.store(begin, std::memory_order_relaxed);
+    slot.end.store(end, std::memory_order_relaxed);
+
+    slot.sequence.store(count + 1, std::memory_order_release);
+
+    buffer->count.store(count + 1, std::memory_order_release);
+}
+
+bool Trace::flush(const char* path)
+{
+    std::ofstream file(path);
+
+    if(!file.is_open())
+        return false;
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+
+    file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+
+    bool first = true;
+
+    for(const auto& buffer : buffers)
+    {
+        const uint64_t count = buffer->count.load(std::memory_order_acquire);
+        const uint64_t oldest = count > Trace::bufferSize ? count - Trace::bufferSize : 0;
+
+        for(uint64_t i = oldest; i < count; ++i)
+        {
+            const Slot& slot = buffer->events[i & (Trace::bufferSize - 1)];
+
+            if(slot.sequence.load(std::memory_order_acquire) != i + 1)
+                continue;
+
+            const Event event {slot.name.load(std::memory_order_relaxed), slot.begin.load(std::memory_order_relaxed), slot.end.load(std::memory_order_relaxed)};
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            // Overwritten by the recording thread while copying
+            if(slot.sequence.load(std::memory_order_relaxed) != i + 1)
+                continue;
+
+            if(!first)
+                file << ",\n";
+
+            first = false;
+
+            // Chrome trace timestamps are in microseconds
+            file << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadID
+                 << ",\"ts\":" << event.begin / 1000.0 << ",\"dur\":" << (event.end - event.begin) / 1000.0 << "}";
+        }
+    }
+
+    file << "\n]}\n";
+
+    return true;
+}
@@ -0,0 +1,85 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <atomic>
+
+// Scoped instrumentation zones exported as Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+// TRACE_ZONE compiles to nothing unless CHIP8_TRACING is defined.
+
+namespace Trace
+{
+    static constexpr uint32_t bufferSize = 1 << 16; // Zones kept per thread, must be a power of two
+
+    struct Event
+    {
+        const char* name; // Must be a string literal
+
+        uint64_t begin; // Nanoseconds since the first zone
+        uint64_t end;
+    };
+
+    // A ring slot the owning thread may overwrite while flush reads it. The sequence is the zone's
+    // index plus one once written and 0 while being written, so a reader that sees the same expected
+    // value before and after copying the fields knows the copy isn't torn.
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence;
+
+        std::atomic<const char*> name;
+        std::atomic<uint64_t> begin;
+        std::atomic<uint64_t> end;
+    };
+
+    struct ThreadBuffer
+    {
+        uint32_t threadID;
+
+        std::atomic<uint64_t> count; // Zones ever written, published after each zone
+
+        std::array<Slot, Trace::bufferSize> events; // Ring of the most recent zones
+    };
+
+    class Zone
+    {
+        private:
+            const char* name;
+
+            uint64_t begin;
+
+        public:
+            Zone(const char* name);
+            ~Zone();
+    };
+
+    uint64_t now();
+
+    void record(const char* name, uint64_t begin, uint64_t end);
+
+    bool flush(const char* path);
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef CHIP8_TRACING
+    #define TRACE_ZONE(name) Trace::Zone TRACE_CONCAT(traceZone, __LINE__)(name)
+#else
+    #define TRACE_ZONE(name)
+#endif
@@ -0,0 +1,359 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "traceindex.h"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "logger.h"
+
+namespace
+{
+    const uint8_t* mapFile(const char* path, size_t& size)
+    {
+        const int fd = ::open(path, O_RDONLY);
+
+        if(fd == -1)
+            return nullptr;
+
+        struct stat info;
+
+        void* data = MAP_FAILED;
+
+        if(fstat(fd, &info) == 0 && info.st_size > 0)
+            data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        ::close(fd);
+
+        if(data == MAP_FAILED)
+            return nullptr;
+
+        size = info.st_size;
+
+        return static_cast<const uint8_t*>(data);
+    }
+}
+
+TraceIndex::TraceIndex() : trace(nullptr), traceSize(0), index(nullptr), indexSize(0), header(nullptr), blocks(nullptr), frames(nullptr), directory(nullptr), postings(nullptr), cachedBlock(-1), savestate(new Chip8::State)
+{
+}
+
+TraceIndex::~TraceIndex()
+{
+    this->close();
+}
+
+bool TraceIndex::open(const char* path)
+{
+    this->close();
+
+    this->trace = mapFile(path, this->traceSize);
+    this->index = mapFile((std::string(path) + ".idx").c_str(), this->indexSize);
+
+    const Recorder::FileHeader* traceHeader = reinterpret_cast<const Recorder::FileHeader*>(this->trace);
+
+    this->header = reinterpret_cast<const Recorder::IndexHeader*>(this->index);
+
+    if(this->trace == nullptr || this->index == nullptr || this->traceSize < sizeof(Recorder::FileHeader) || this->indexSize < sizeof(Recorder::IndexHeader)
+        || std::memcmp(traceHeader->magic, "C8TR", 4) != 0 || traceHeader->version != Recorder::version || traceHeader->recordSize != sizeof(Recorder::Record)
+        || std::memcmp(this->header->magic, "C8TI", 4) != 0 || this->header->version != Recorder::version)
+    {
+        Logger::log(Logger::Level::Error, "Couldn't open trace or its index: {s}", path);
+
+        this->close();
+
+        return false;
+    }
+
+    const size_t expectedSize = sizeof(Recorder::IndexHeader) + this->header->blockCount * sizeof(Recorder::IndexBlock) + this->header->frameCount * sizeof(Recorder::IndexFrame)
+        + Recorder::postingListCount * sizeof(Recorder::IndexPostings) + this->header->postingCount * sizeof(uint32_t);
+
+    if(this->indexSize != expectedSize)
+    {
+        Logger::log(Logger::Level::Error, "Trace index is truncated: {s}", path);
+
+        this->close();
+
+        return false;
+    }
+
+    this->blocks = reinterpret_cast<const Recorder::IndexBlock*>(this->index + sizeof(Recorder::IndexHeader));
+    this->frames = reinterpret_cast<const Recorder::IndexFrame*>(this->blocks + this->header->blockCount);
+    this->directory = reinterpret_cast<const Recorder::IndexPostings*>(this->frames + this->header->frameCount);
+    this->postings = reinterpret_cast<const uint32_t*>(this->directory + Recorder::postingListCount);
+
+    // Savestates are few and large, only their offsets are kept
+    this->statesPath = std::string(path) + ".states";
+
+    std::FILE* statesFile = std::fopen(this->statesPath.c_str(), "rb");
+
+    if(statesFile != nullptr)
+    {
+        Recorder::StateHeader state;
+
+        while(std::fread(&state, sizeof(state), 1, statesFile) == 1)
+        {
+            if(state.size == sizeof(Chip8::State))
+                this->states.push_back({state.frame, std::ftell(statesFile)});
+
+            if(std::fseek(statesFile, state.size, SEEK_CUR) != 0)
+                break;
+        }
+
+        std::fclose(statesFile);
+    }
+
+    return true;
+}
+
+void TraceIndex::close()
+{
+    if(this->trace != nullptr)
+        munmap(const_cast<uint8_t*>(this->trace), this->traceSize);
+
+    if(this->index != nullptr)
+        munmap(const_cast<uint8_t*>(this->index), this->indexSize);
+
+    this->trace = nullptr;
+    this->index = nullptr;
+    this->header = nullptr;
+
+    this->states.clear();
+
+    this->cachedBlock = -1;
+}
+
+bool TraceIndex::isOpen() const
+{
+    return this->header != nullptr;
+}
+
+uint64_t TraceIndex::getRecordCount() const
+{
+    return this->isOpen() ? this->header->recordCount : 0;
+}
+
+uint32_t TraceIndex::getFrameCount() const
+{
+    return this->isOpen() ? this->header->frameCount : 0;
+}
+
+uint32_t TraceIndex::getFirstFrame() const
+{
+    return this->getFrameCount() > 0 ? this->frames[0].frame : 0;
+}
+
+bool TraceIndex::loadBlock(uint32_t block)
+{
+    if(this->cachedBlock == block)
+        return true;
+
+    const uint64_t offset = this->blocks[block].fileOffset;
+
+    if(offset + sizeof(Recorder::BlockHeader) > this->traceSize)
+        return false;
+
+    Recorder::BlockHeader blockHeader;
+
+    std::memcpy(&blockHeader, this->trace + offset, sizeof(blockHeader));
+
+    if(blockHeader.recordCount > Recorder::blockRecords || offset + sizeof(blockHeader) + blockHeader.compressedSize > this->traceSize)
+        return false;
+
+    this->blockRecords.resize(blockHeader.recordCount);
+
+    if(!Recorder::decompressBlock(this->trace + offset + sizeof(blockHeader), blockHeader.compressedSize, this->blockRecords.data(), blockHeader.recordCount))
+        return false;
+
+    this->cachedBlock = block;
+
+    return true;
+}
+
+uint32_t TraceIndex::findBlock(uint64_t record) const
+{
+    // Blocks are full apart from the last one
+    return std::min<uint64_t>(record / Recorder::blockRecords, this->header->blockCount - 1);
+}
+
+bool TraceIndex::getRecord(uint64_t record, Recorder::Record& result)
+{
+    if(record >= this->getRecordCount())
+        return false;
+
+    const uint32_t block = this->findBlock(record);
+
+    if(!this->loadBlock(block))
+        return false;
+
+    result = this->blockRecords[record - this->blocks[block].firstRecord];
+
+    return true;
+}
+
+int64_t TraceIndex::findFrame(uint32_t frame) const
+{
+    if(frame < this->getFirstFrame() || frame - this->getFirstFrame() >= this->getFrameCount())
+        return TraceIndex::notFound;
+
+    return this->frames[frame - this->getFirstFrame()].firstRecord;
+}
+
+int64_t TraceIndex::findLastExecution(uint16_t pc, uint64_t before)
+{
+    if(!this->isOpen() || before == 0)
+        return TraceIndex::notFound;
+
+    const Recorder::IndexPostings& list = this->directory[pc & 0xFFF];
+
+    const uint32_t* first = this->postings + list.offset;
+    const uint32_t* last = first + list.count;
+
+    // Walk the blocks that executed pc backwards, starting with the one holding the record before 'before'
+    const uint32_t startBlock = this->findBlock(before - 1);
+
+    for(const uint32_t* block = std::upper_bound(first, last, startBlock); block != first;)
+    {
+        --block;
+
+        if(!this->loadBlock(*block))
+            return TraceIndex::notFound;
+
+        const uint64_t blockStart = this->blocks[*block].firstRecord;
+        const uint64_t blockEnd = std::min<uint64_t>(blockStart + this->blockRecords.size(), before);
+
+        for(uint64_t record = blockEnd; record-- > blockStart;)
+        {
+            const Recorder::Record& candidate = this->blockRecords[record - blockStart];
+
+            if(candidate.pc == pc && !(candidate.flags & Recorder::flagMarker))
+                return record;
+        }
+    }
+
+    return TraceIndex::notFound;
+}
+
+int64_t TraceIndex::findLastWriter(uint8_t writer, uint64_t before)
+{
+    if(!this->isOpen() || before == 0 || writer >= Recorder::writerCount)
+        return TraceIndex::notFound;
+
+    before = std::min(before, this->getRecordCount());
+
+    const uint32_t block = this->findBlock(before - 1);
+
+    if(!this->loadBlock(block))
+        return TraceIndex::notFound;
+
+    const uint64_t blockStart = this->blocks[block].firstRecord;
+
+    for(uint64_t record = before; record-- > blockStart;)
+    {
+        if(Recorder::getWrittenMask(this->blockRecords[record - blockStart]) & (1 << writer))
+            return record;
+    }
+
+    // The checkpoint covers everything before the block
+    return this->blocks[block].lastWriters[writer];
+}
+
+bool TraceIndex::seek(Chip8& chip8, uint64_t record)
+{
+    Recorder::Record target;
+
+    if(!this->getRecord(record, target))
+        return false;
+
+    // Latest savestate at or before the target frame
+    auto state = std::upper_bound(this->states.begin(), this->states.end(), std::make_pair(target.frame, LONG_MAX));
+
+    if(state == this->states.begin())
+        return false;
+
+    --state;
+
+    std::FILE* statesFile = std::fopen(this->statesPath.c_str(), "rb");
+
+    if(statesFile == nullptr)
+        return false;
+
+    const bool loaded = std::fseek(statesFile, state->second, SEEK_SET) == 0 && std::fread(this->savestate.get(), sizeof(Chip8::State), 1, statesFile) == 1;
+
+    std::fclose(statesFile);
+
+    if(!loaded)
+        return false;
+
+    chip8.loadState(*this->savestate);
+
+    std::array<Chip8::KeyEvent, Chip8::maxKeyEvents> events;
+
+    for(uint32_t frame = state->first; frame < target.frame; ++frame)
+    {
+        const Recorder::IndexFrame& entry = this->frames[frame - this->getFirstFrame()];
+
+        const uint8_t eventCount = this->getKeyEvents(entry, events.data());
+
+        chip8.replayFrame(entry.keys, entry.instructions, events.data(), eventCount);
+    }
+
+    // Finish with the instructions of the target frame that ran before the record
+    const int64_t marker = this->findFrame(target.frame);
+
+    if(marker == TraceIndex::notFound)
+        return false;
+
+    const Recorder::IndexFrame& entry = this->frames[target.frame - this->getFirstFrame()];
+
+    const uint64_t firstInstruction = marker + 1 + entry.events;
+
+    if(record > firstInstruction)
+    {
+        const uint8_t eventCount = this->getKeyEvents(entry, events.data());
+
+        chip8.beginFrame(entry.keys, events.data(), eventCount);
+    }
+
+    for(uint64_t i = firstInstruction; i < record; ++i)
+        chip8.step();
+
+    return chip8.cpu.pc == target.pc;
+}
+
+uint8_t TraceIndex::getKeyEvents(const Recorder::IndexFrame& frame, Chip8::KeyEvent* events)
+{
+    const uint8_t eventCount = std::min(frame.events, Chip8::maxKeyEvents);
+
+    Recorder::Record record;
+
+    for(uint8_t i = 0; i < eventCount; ++i)
+    {
+        if(!this->getRecord(frame.firstRecord + 1 + i, record) || !(record.flags & Recorder::flagKeyEvent))
+            return i;
+
+        events[i] = {static_cast<uint8_t>(record.i), record.word};
+    }
+
+    return eventCount;
+}
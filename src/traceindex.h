@@ -0,0 +1,91 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "chip8.h"
+#include "recorder.h"
+
+// Answers questions about a recorded trace from its memory-mapped index instead of scanning it,
+// and moves a Chip8 to any recorded instruction by loading the nearest savestate and replaying.
+
+class TraceIndex
+{
+    public:
+        static constexpr int64_t notFound = -1;
+
+    private:
+        const uint8_t* trace;
+        size_t traceSize;
+
+        const uint8_t* index;
+        size_t indexSize;
+
+        const Recorder::IndexHeader* header;
+        const Recorder::IndexBlock* blocks;
+        const Recorder::IndexFrame* frames;
+        const Recorder::IndexPostings* directory;
+        const uint32_t* postings;
+
+        std::string statesPath;
+
+        std::vector<std::pair<uint32_t, long>> states; // Frame and file offset of every savestate
+
+        int64_t cachedBlock;
+
+        std::vector<Recorder::Record> blockRecords;
+
+        std::unique_ptr<Chip8::State> savestate; // Read back by seek, allocated once
+
+    private:
+        bool loadBlock(uint32_t block);
+
+        uint32_t findBlock(uint64_t record) const;
+
+        uint8_t getKeyEvents(const Recorder::IndexFrame& frame, Chip8::KeyEvent* events); // Reads the key event records after a frame's marker
+
+    public:
+        TraceIndex();
+        ~TraceIndex();
+
+        bool open(const char* path);
+
+        void close();
+
+        bool isOpen() const;
+
+        uint64_t getRecordCount() const;
+
+        uint32_t getFrameCount() const;
+
+        uint32_t getFirstFrame() const;
+
+        bool getRecord(uint64_t record, Recorder::Record& result);
+
+        int64_t findFrame(uint32_t frame) const; // The frame's marker record
+
+        int64_t findLastExecution(uint16_t pc, uint64_t before); // Last record before this one that executed pc
+
+        int64_t findLastWriter(uint8_t writer, uint64_t before); // Last record before this one that wrote Vn, or I for 16
+
+        bool seek(Chip8& chip8, uint64_t record); // Leaves chip8 about to execute the record
+};
@@ -0,0 +1,129 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "watchpoints.h"
+#include "memory.h"
+#include <utility>
+
+Watchpoints::Watchpoints() : triggered(false), hit{}
+{
+
+}
+
+bool Watchpoints::isActive() const
+{
+    return !this->watches.empty();
+}
+
+const std::vector<Watchpoints::Watch>& Watchpoints::getWatches() const
+{
+    return this->watches;
+}
+
+void Watchpoints::add(Memory& memory, uint16_t start, uint16_t end, uint8_t kinds)
+{
+    start &= Memory::memorySize - 1;
+    end &= Memory::memorySize - 1;
+
+    if(end < start)
+        std::swap(start, end);
+
+    this->watches.push_back({start, end, kinds});
+
+    this->updatePages(memory);
+}
+
+void Watchpoints::remove(Memory& memory, size_t index)
+{
+    if(index >= this->watches.size())
+        return;
+
+    this->watches.erase(this->watches.begin() + index);
+
+    this->updatePages(memory);
+}
+
+void Watchpoints::clear(Memory& memory)
+{
+    this->watches.clear();
+
+    this->updatePages(memory);
+}
+
+void Watchpoints::updatePages(Memory& memory)
+{
+    memory.watchedReadPages = 0;
+    memory.watchedWritePages = 0;
+
+    for(const Watch& watch : this->watches)
+    {
+        for(uint16_t page = watch.start / Watchpoints::pageSize; page <= watch.end / Watchpoints::pageSize; ++page)
+        {
+            if(watch.kinds & Kind::Read)
+                memory.watchedReadPages |= uint64_t(1) << page;
+
+            if(watch.kinds & (Kind::Write | Kind::Change))
+                memory.watchedWritePages |= uint64_t(1) << page;
+        }
+    }
+}
+
+void Watchpoints::checkRead(uint16_t address, uint8_t value)
+{
+    // Keep the first hit of an instruction that touches several watched bytes
+    if(this->triggered)
+        return;
+
+    for(const Watch& watch : this->watches)
+    {
+        if(!(watch.kinds & Kind::Read) || address < watch.start || address > watch.end)
+            continue;
+
+        this->triggered = true;
+        this->hit = {0, address, Kind::Read, value, value};
+
+        return;
+    }
+}
+
+void Watchpoints::checkWrite(uint16_t address, uint8_t oldValue, uint8_t newValue)
+{
+    // Keep the first hit of an instruction that touches several watched bytes
+    if(this->triggered)
+        return;
+
+    for(const Watch& watch : this->watches)
+    {
+        if(address < watch.start || address > watch.end)
+            continue;
+
+        if(watch.kinds & Kind::Write)
+        {
+            this->triggered = true;
+            this->hit = {0, address, Kind::Write, oldValue, newValue};
+
+            return;
+        }
+
+        if((watch.kinds & Kind::Change) && oldValue != newValue)
+        {
+            this->triggered = true;
+            this->hit = {0, address, Kind::Change, oldValue, newValue};
+
+            return;
+        }
+    }
+}
@@ -0,0 +1,83 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+
+class Memory;
+
+class Watchpoints
+{
+    public:
+        static constexpr uint16_t pageSize = 64; // Granularity of the filter kept in Memory
+
+        enum Kind : uint8_t
+        {
+            Read = 1 << 0,
+            Write = 1 << 1,
+            Change = 1 << 2, // Writes that store a different value
+        };
+
+        struct Watch
+        {
+            uint16_t start;
+            uint16_t end; // Inclusive
+
+            uint8_t kinds;
+        };
+
+        struct Hit
+        {
+            uint16_t pc; // Instruction that made the access, filled in by Chip8
+            uint16_t address;
+
+            Kind kind;
+
+            uint8_t oldValue;
+            uint8_t newValue;
+        };
+
+    private:
+        std::vector<Watch> watches;
+
+    public:
+        bool triggered; // Set by an access matching a watch, cleared before every checked instruction
+
+        Hit hit;
+
+    private:
+        void updatePages(Memory& memory);
+
+    public:
+        Watchpoints();
+
+        bool isActive() const;
+
+        const std::vector<Watch>& getWatches() const;
+
+        void add(Memory& memory, uint16_t start, uint16_t end, uint8_t kinds);
+
+        void remove(Memory& memory, size_t index);
+
+        void clear(Memory& memory);
+
+        // Called by Memory only for accesses on a watched page
+        void checkRead(uint16_t address, uint8_t value);
+        void checkWrite(uint16_t address, uint8_t oldValue, uint8_t newValue);
+};
@@ -0,0 +1,94 @@
+//     Chip-8 emulator, debugger, and disassembler.
+//     Copyright (C) 2024 Om Rawaley (@omrawaley)
+
+//     This program is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+
+//     You should have received a copy of the GNU General Public License
+//     along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "../src/allocations.h"
+#include "../src/analysis.h"
+#include "../src/chip8.h"
+#include "../src/disassemblycache.h"
+#include "../src/history.h"
+
+// Fails when a steady-state frame of the core or the disassembly cache touches the heap.
+// Built with CHIP8_COUNT_ALLOCATIONS so Allocations::getCount sees every operator new.
+
+namespace
+{
+    constexpr uint32_t warmupFrames = 120; // Same allowance as Profiler::warmupFrames
+    constexpr uint32_t measuredFrames = 600;
+
+    // Draws, calls a subroutine, stores BCD to memory and polls the delay timer
+    constexpr uint8_t rom[] =
+    {
+        0x00, 0xE0, 0x6C, 0x7B, 0xA3, 0x00, 0xFC, 0x33, 0xF2, 0x55, 0xF2, 0x65,
+        0x60, 0x00, 0x61, 0x00, 0xA2, 0x24, 0xD0, 0x15, 0x70, 0x08, 0x6A, 0x03,
+        0xFA, 0x15, 0xFB, 0x07, 0x3B, 0x00, 0x12, 0x1A, 0x22, 0x2A, 0x12, 0x12,
+        0xF0, 0x90, 0x90, 0x90, 0xF0, 0x00, 0x71, 0x01, 0x00, 0xEE,
+    };
+
+    void runFrame(Chip8& chip8, DisassemblyCache& cache, const Analysis& analysis, uint32_t frame)
+    {
+        // A press and release every half second, landing mid-frame
+        const Chip8::KeyEvent events[] = {{3, static_cast<uint16_t>((frame / 30) % 2 << 5)}};
+
+        chip8.emulateCycle(chip8.keypad.getMask(), events, 1);
+
+        // As the Disassembly window does, the layout follows the PC
+        cache.layout(&analysis, CPU::pcStart + sizeof(rom), chip8.cpu.pc);
+
+        for(uint16_t row = 0; row < cache.getRowCount(); ++row)
+            cache.get(chip8.memory, cache.getAddress(row));
+    }
+}
+
+int main()
+{
+    if(!Allocations::isCounting())
+    {
+        std::fprintf(stderr, "Built without CHIP8_COUNT_ALLOCATIONS\n");
+        return EXIT_FAILURE;
+    }
+
+    static Chip8 chip8;
+    static History history;
+    static DisassemblyCache cache;
+
+    chip8.history = &history;
+
+    for(size_t i = 0; i < sizeof(rom); ++i)
+        chip8.memory[CPU::pcStart + i] = rom[i];
+
+    chip8.memory.romSize = sizeof(rom);
+    chip8.memory.romLoaded = true;
+
+    const std::shared_ptr<const Analysis> analysis = Analysis::get(rom, sizeof(rom));
+    chip8.instructionsPerSecond = 20;
+
+    for(uint32_t frame = 0; frame < warmupFrames; ++frame)
+        runFrame(chip8, cache, *analysis, frame);
+
+    const uint64_t allocations = Allocations::getCount();
+
+    for(uint32_t frame = warmupFrames; frame < warmupFrames + measuredFrames; ++frame)
+        runFrame(chip8, cache, *analysis, frame);
+
+    const uint64_t steadyAllocations = Allocations::getCount() - allocations;
+
+    std::printf("%llu heap allocations in %u steady-state frames\n", static_cast<unsigned long long>(steadyAllocations), measuredFrames);
+
+    return steadyAllocations == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}